@@ -0,0 +1,386 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+/*
+Memory resources for node heavy containers, and the standard allocators over them that Vector, SmallVector, List
+and BST (or any standard container) take as their Allocator parameter. The allocators only hold a pointer to the
+resource: it must outlive every container using it. Neither resource is thread safe, one per thread or per
+structure is what keeps such work off the global heap and its locks.
+*/
+
+/*
+Hands out memory by bumping a pointer through chunks obtained from operator new; deallocate does nothing.
+Everything is given back at once by release() or the destructor, in one operator delete per chunk, however many
+nodes were carved. Chunks double in size, starting at chunk_size bytes.
+*/
+class MonotonicArena {
+private:
+	struct Chunk {
+		Chunk* mNext;
+		std::size_t mSize; // bytes, header included
+	};
+
+	Chunk* mChunks;
+	char* mCur;
+	char* mEnd;
+	std::size_t mNextSize;
+	std::size_t mInitialSize;
+	std::size_t mAllocated;
+
+	// bytes to skip from ptr to the next multiple of alignment
+	static std::size_t padding(const char* ptr, std::size_t alignment)
+	{
+		std::size_t offset = reinterpret_cast<std::size_t>(ptr) % alignment;
+		return offset ? alignment - offset : 0;
+	}
+
+	void addChunk(std::size_t bytes, std::size_t alignment)
+	{
+		std::size_t size = mNextSize;
+		while (size < sizeof(Chunk) + bytes + alignment)
+			size *= 2;
+
+		Chunk* chunk = static_cast<Chunk*>(::operator new(size));
+		chunk->mNext = mChunks;
+		chunk->mSize = size;
+		mChunks = chunk;
+		mCur = reinterpret_cast<char*>(chunk + 1);
+		mEnd = reinterpret_cast<char*>(chunk) + size;
+		mNextSize = size * 2;
+	}
+public:
+	explicit MonotonicArena(std::size_t chunk_size = 4096)
+		: mChunks(nullptr), mCur(nullptr), mEnd(nullptr), mNextSize(chunk_size < 64 ? 64 : chunk_size),
+		mInitialSize(mNextSize), mAllocated(0)
+	{
+
+	}
+
+	MonotonicArena(const MonotonicArena&) = delete;
+	MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+	void* allocate(std::size_t bytes, std::size_t alignment)
+	{
+		// compared as sizes: the aligned position can lie past mEnd
+		if (mCur == nullptr || static_cast<std::size_t>(mEnd - mCur) < padding(mCur, alignment) + bytes)
+			addChunk(bytes, alignment);
+		char* ptr = mCur + padding(mCur, alignment);
+
+		mCur = ptr + bytes;
+		mAllocated += bytes;
+		return ptr;
+	}
+
+	void deallocate(void*, std::size_t, std::size_t)
+	{
+
+	}
+
+	/*
+	Frees every chunk. Whatever was allocated from the arena must not be used anymore, containers included.
+	*/
+	void release()
+	{
+		while (mChunks)
+		{
+			Chunk* next = mChunks->mNext;
+			::operator delete(mChunks);
+			mChunks = next;
+		}
+		mCur = mEnd = nullptr;
+		mNextSize = mInitialSize;
+		mAllocated = 0;
+	}
+
+	/*
+	Returns the number of bytes handed out since construction or the last release().
+	*/
+	std::size_t allocated() const
+	{
+		return mAllocated;
+	}
+
+	~MonotonicArena()
+	{
+		release();
+	}
+};
+
+/*
+Blocks of one size, recycled through a free list. The block size is fixed by the first allocation (a container's
+node, typically) unless given up front; requests of another size or stricter alignment than max_align_t go to
+operator new, so a pool can be shared with whatever else the container allocates.
+Freed blocks are reused first; chunks of blocks_per_chunk blocks are only returned by release() or the destructor.
+*/
+class NodePool {
+private:
+	static const std::size_t Alignment = alignof(std::max_align_t);
+
+	struct FreeBlock {
+		FreeBlock* mNext;
+	};
+
+	struct Chunk {
+		Chunk* mNext;
+	};
+
+	static std::size_t blockSize(std::size_t bytes)
+	{
+		if (bytes < sizeof(FreeBlock))
+			bytes = sizeof(FreeBlock);
+		return (bytes + Alignment - 1) / Alignment * Alignment;
+	}
+
+	// blocks start Alignment bytes into a chunk, past its header
+	static const std::size_t HeaderSize = (sizeof(Chunk) + Alignment - 1) / Alignment * Alignment;
+
+	Chunk* mChunks;
+	FreeBlock* mFree;
+	char* mCur;
+	char* mEnd;
+	std::size_t mBlockSize;
+	std::size_t mBlocksPerChunk;
+	std::size_t mInUse;
+
+	bool pooled(std::size_t bytes, std::size_t alignment)
+	{
+		if (alignment > Alignment)
+			return false;
+		if (mBlockSize == 0)
+			mBlockSize = blockSize(bytes);
+		return blockSize(bytes) == mBlockSize;
+	}
+
+	/*
+	Gets a block that is not pooled straight from operator new. Alignments beyond what plain operator new gives
+	need the aligned operator new of C++17; before it they are not supported, as with std::allocator.
+	*/
+	static void* newBlock(std::size_t bytes, std::size_t alignment)
+	{
+#ifdef __cpp_aligned_new
+		if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+			return ::operator new(bytes, std::align_val_t(alignment));
+#else
+		assert(alignment <= alignof(std::max_align_t));
+		(void)alignment;
+#endif
+		return ::operator new(bytes);
+	}
+
+	static void deleteBlock(void* ptr, std::size_t alignment)
+	{
+#ifdef __cpp_aligned_new
+		if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+		{
+			::operator delete(ptr, std::align_val_t(alignment));
+			return;
+		}
+#else
+		(void)alignment;
+#endif
+		::operator delete(ptr);
+	}
+
+	void addChunk()
+	{
+		char* chunk = static_cast<char*>(::operator new(HeaderSize + mBlockSize * mBlocksPerChunk));
+		reinterpret_cast<Chunk*>(chunk)->mNext = mChunks;
+		mChunks = reinterpret_cast<Chunk*>(chunk);
+		mCur = chunk + HeaderSize;
+		mEnd = mCur + mBlockSize * mBlocksPerChunk;
+	}
+public:
+	explicit NodePool(std::size_t block_size = 0, std::size_t blocks_per_chunk = 256)
+		: mChunks(nullptr), mFree(nullptr), mCur(nullptr), mEnd(nullptr), mBlockSize(block_size ? blockSize(block_size) : 0),
+		mBlocksPerChunk(blocks_per_chunk ? blocks_per_chunk : 1), mInUse(0)
+	{
+
+	}
+
+	NodePool(const NodePool&) = delete;
+	NodePool& operator=(const NodePool&) = delete;
+
+	void* allocate(std::size_t bytes, std::size_t alignment)
+	{
+		if (!pooled(bytes, alignment))
+		{
+			return newBlock(bytes, alignment);
+		}
+
+		++mInUse;
+		if (FreeBlock* block = mFree)
+		{
+			mFree = block->mNext;
+			return block;
+		}
+
+		if (mCur == mEnd)
+			addChunk();
+		void* block = mCur;
+		mCur += mBlockSize;
+		return block;
+	}
+
+	void deallocate(void* ptr, std::size_t bytes, std::size_t alignment)
+	{
+		if (!pooled(bytes, alignment))
+		{
+			deleteBlock(ptr, alignment);
+			return;
+		}
+
+		--mInUse;
+		FreeBlock* block = static_cast<FreeBlock*>(ptr);
+		block->mNext = mFree;
+		mFree = block;
+	}
+
+	/*
+	Frees every chunk. Pooled blocks must not be used anymore; blocks that went to operator new are not affected.
+	*/
+	void release()
+	{
+		while (mChunks)
+		{
+			Chunk* next = mChunks->mNext;
+			::operator delete(mChunks);
+			mChunks = next;
+		}
+		mFree = nullptr;
+		mCur = mEnd = nullptr;
+		mInUse = 0;
+	}
+
+	/*
+	Returns the size of the pooled blocks, 0 until it is fixed.
+	*/
+	std::size_t block_size() const
+	{
+		return mBlockSize;
+	}
+
+	/*
+	Returns the number of pooled blocks currently allocated.
+	*/
+	std::size_t in_use() const
+	{
+		return mInUse;
+	}
+
+	~NodePool()
+	{
+		release();
+	}
+};
+
+/*
+Standard allocator over a MonotonicArena. Copies, rebound ones included, share the arena and compare equal.
+*/
+template <typename T>
+class MonotonicAllocator {
+private:
+	template <typename>
+	friend class MonotonicAllocator;
+
+	MonotonicArena* mArena;
+public:
+	using value_type = T;
+
+	explicit MonotonicAllocator(MonotonicArena& arena) : mArena(&arena)
+	{
+
+	}
+
+	template <typename U>
+	MonotonicAllocator(const MonotonicAllocator<U>& other) : mArena(other.mArena)
+	{
+
+	}
+
+	T* allocate(std::size_t count)
+	{
+		if (count > std::numeric_limits<std::size_t>::max() / sizeof(T))
+			throw std::bad_array_new_length();
+		return static_cast<T*>(mArena->allocate(count * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T* ptr, std::size_t count)
+	{
+		mArena->deallocate(ptr, count * sizeof(T), alignof(T));
+	}
+
+	MonotonicArena& arena() const
+	{
+		return *mArena;
+	}
+
+	template <typename U>
+	bool operator==(const MonotonicAllocator<U>& other) const
+	{
+		return mArena == other.mArena;
+	}
+
+	template <typename U>
+	bool operator!=(const MonotonicAllocator<U>& other) const
+	{
+		return mArena != other.mArena;
+	}
+};
+
+/*
+Standard allocator over a NodePool. Copies, rebound ones included, share the pool and compare equal.
+*/
+template <typename T>
+class PoolAllocator {
+private:
+	template <typename>
+	friend class PoolAllocator;
+
+	NodePool* mPool;
+public:
+	using value_type = T;
+
+	explicit PoolAllocator(NodePool& pool) : mPool(&pool)
+	{
+
+	}
+
+	template <typename U>
+	PoolAllocator(const PoolAllocator<U>& other) : mPool(other.mPool)
+	{
+
+	}
+
+	T* allocate(std::size_t count)
+	{
+		if (count > std::numeric_limits<std::size_t>::max() / sizeof(T))
+			throw std::bad_array_new_length();
+		return static_cast<T*>(mPool->allocate(count * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T* ptr, std::size_t count)
+	{
+		mPool->deallocate(ptr, count * sizeof(T), alignof(T));
+	}
+
+	NodePool& pool() const
+	{
+		return *mPool;
+	}
+
+	template <typename U>
+	bool operator==(const PoolAllocator<U>& other) const
+	{
+		return mPool == other.mPool;
+	}
+
+	template <typename U>
+	bool operator!=(const PoolAllocator<U>& other) const
+	{
+		return mPool != other.mPool;
+	}
+};
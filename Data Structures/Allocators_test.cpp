@@ -0,0 +1,179 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "Allocators.h"
+#include "BST.h"
+#include "List.h"
+#include "Vector.h"
+
+/*
+Tests of MonotonicArena and NodePool: alignment, blocks never overlapping or leaving their chunk, whatever the
+chunk size and the mix of sizes and alignments, block reuse, and containers running on both.
+Build and run, preferably with AddressSanitizer, which catches a block written past its chunk:
+	g++ -std=c++17 -g -fsanitize=address,undefined Allocators_test.cpp -o Allocators_test && ./Allocators_test
+Checks stay on with NDEBUG. Prints "ok" at the end; any failure exits with status 1.
+*/
+
+static void check(bool condition, const char* what)
+{
+	if (!condition)
+	{
+		std::fprintf(stderr, "FAILED: %s\n", what);
+		std::exit(1);
+	}
+}
+
+static bool aligned(const void* ptr, std::size_t alignment)
+{
+	return reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0;
+}
+
+struct Block {
+	unsigned char* mPtr;
+	std::size_t mBytes;
+	unsigned char mFill;
+};
+
+/*
+Fills every block with its own byte, so a block overlapping another shows up once all are checked.
+*/
+static void fill(std::vector<Block>& blocks, void* ptr, std::size_t bytes)
+{
+	Block block{static_cast<unsigned char*>(ptr), bytes, static_cast<unsigned char>(blocks.size() * 31 + 7)};
+	std::memset(block.mPtr, block.mFill, bytes);
+	blocks.push_back(block);
+}
+
+static void checkBlocks(const std::vector<Block>& blocks, const char* what)
+{
+	for (const Block& block : blocks)
+		for (std::size_t i = 0; i < block.mBytes; ++i)
+			check(block.mPtr[i] == block.mFill, what);
+}
+
+/*
+An aligned position past the end of the chunk must not be taken for room left in it: a chunk size that is not a
+multiple of the alignment leaves fewer bytes than the padding.
+*/
+static void testArenaChunkEnd()
+{
+	MonotonicArena arena(100);
+	std::vector<Block> blocks;
+	for (int i = 0; i < 82; ++i)
+		fill(blocks, arena.allocate(1, 1), 1);
+	void* ptr = arena.allocate(8, 8);
+	check(aligned(ptr, 8), "arena alignment at chunk end");
+	fill(blocks, ptr, 8);
+	checkBlocks(blocks, "arena block at chunk end");
+	check(arena.allocated() == 90, "arena allocated bytes");
+}
+
+/*
+Random sizes and alignments, over-aligned ones included, on arenas whose chunk sizes are not multiples of them.
+*/
+static void testArenaRandom()
+{
+	std::mt19937 rng(1);
+	const std::size_t alignments[] = {1, 2, 4, 8, 16, 32, 64, 128};
+	for (std::size_t chunk : {1, 63, 64, 100, 127, 1000, 4097})
+	{
+		MonotonicArena arena(chunk);
+		std::vector<Block> blocks;
+		for (int i = 0; i < 5000; ++i)
+		{
+			std::size_t alignment = alignments[rng() % 8];
+			std::size_t bytes = rng() % 3 == 0 ? rng() % 300 + 1 : rng() % 24 + 1;
+			void* ptr = arena.allocate(bytes, alignment);
+			check(aligned(ptr, alignment), "arena alignment");
+			fill(blocks, ptr, bytes);
+		}
+		checkBlocks(blocks, "arena blocks overlap");
+		arena.release();
+		check(arena.allocated() == 0, "arena release");
+		fill(blocks, arena.allocate(16, 16), 16);
+	}
+}
+
+/*
+Freed blocks come back first; other sizes and over-aligned requests go to operator new and back.
+*/
+static void testPool()
+{
+	NodePool pool(24, 3);
+	std::vector<void*> pooled;
+	std::vector<Block> blocks;
+	for (int i = 0; i < 100; ++i)
+	{
+		void* ptr = pool.allocate(24, 8);
+		check(aligned(ptr, alignof(std::max_align_t)), "pool alignment");
+		pooled.push_back(ptr);
+		fill(blocks, ptr, 24);
+	}
+	checkBlocks(blocks, "pool blocks overlap");
+	check(pool.in_use() == 100, "pool in use");
+
+	void* freed = pooled[50];
+	pool.deallocate(freed, 24, 8);
+	check(pool.allocate(20, 4) == freed, "pool reuses freed block");
+
+	void* large = pool.allocate(1000, 8);
+	check(pool.in_use() == 100, "pool counts unpooled requests");
+	std::memset(large, 1, 1000);
+	pool.deallocate(large, 1000, 8);
+#ifdef __cpp_aligned_new
+	void* overAligned = pool.allocate(24, 4 * alignof(std::max_align_t));
+	check(aligned(overAligned, 4 * alignof(std::max_align_t)), "pool over-aligned request");
+	check(pool.in_use() == 100, "pool counts unpooled requests");
+	std::memset(overAligned, 1, 24);
+	pool.deallocate(overAligned, 24, 4 * alignof(std::max_align_t));
+#endif
+
+	for (void* ptr : pooled)
+		pool.deallocate(ptr, 24, 8);
+	check(pool.in_use() == 0, "pool in use after deallocation");
+}
+
+/*
+Containers built on both resources hold what was put in them.
+*/
+static void testContainers()
+{
+	MonotonicArena arena(100);
+	NodePool pool;
+	List<int, MonotonicAllocator<int> > list{MonotonicAllocator<int>(arena)};
+	BST<int, PoolAllocator<int> > tree{PoolAllocator<int>(pool)};
+	Vector<long long, MonotonicAllocator<long long> > vector{MonotonicAllocator<long long>(arena)};
+	for (int i = 0; i < 10000; ++i)
+	{
+		list.push_back(i);
+		tree.insert(i * 7 % 10000);
+		vector.push_back(i);
+	}
+
+	long long sum = 0;
+	for (int value : list)
+		sum += value;
+	check(sum == 10000LL * 9999 / 2 && list.size() == 10000, "list on arena");
+	int expected = 0;
+	for (auto it = tree.begin(); it != tree.end(); ++it)
+		check(*it == expected++, "tree on pool");
+	check(expected == 10000, "tree on pool");
+	for (int i = 0; i < 10000; ++i)
+		check(vector[i] == i, "vector on arena");
+	tree.clear();
+	check(pool.in_use() == 0, "tree leaves pool blocks in use");
+}
+
+int main()
+{
+	testArenaChunkEnd();
+	testArenaRandom();
+	testPool();
+	testContainers();
+	std::printf("ok\n");
+	return 0;
+}
@@ -1,24 +1,70 @@
 #pragma once
+#include <algorithm>
 #include <initializer_list>
 #include <iterator>
+#include <type_traits>
+#include <memory>
 #include <utility>
 #include <cassert>
 
-template <typename T>
-class BST {
+/*
+Ordered container allowing duplicates, kept height balanced as an AVL tree: the heights of the two subtrees of any
+node differ by at most one, so find, insert and erase are O(log n) whatever the order of insertion.
+Every node also counts the elements of its subtree, which makes select (k-th element) and rank O(log n) too.
+Nodes are never moved or copied by rebalancing, so iterators stay valid until their own element is erased.
+Nodes come from Allocator, a standard allocator rebound to the node type.
+The allocator is a (private, so empty ones take no room) base of the container.
+*/
+template <typename T, typename Allocator = std::allocator<T> >
+class BST : private Allocator {
 protected:
     struct Node {
         T mData;
         Node* mParent;
         Node* mLeft;
         Node* mRight;
+        int mHeight; // of the subtree rooted here, 1 for a leaf
+        std::size_t mCount; // elements in the subtree rooted here
         Node(const T& Data, Node* Parent = nullptr, Node* Left = nullptr, Node* Right = nullptr)
-            : mData(Data), mParent(Parent), mLeft(Left), mRight(Right)
+            : mData(Data), mParent(Parent), mLeft(Left), mRight(Right), mHeight(1), mCount(1)
         {
 
         }
     };
 
+    using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using NodeTraits = std::allocator_traits<NodeAllocator>;
+
+    /*
+    Allocates a node and constructs it from args.
+    */
+    template <typename... Args>
+    Node* create_node(Args&&... args)
+    {
+        NodeAllocator allocator(get_allocator());
+        Node* node = NodeTraits::allocate(allocator, 1);
+        try
+        {
+            NodeTraits::construct(allocator, node, std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            NodeTraits::deallocate(allocator, node, 1);
+            throw;
+        }
+        return node;
+    }
+
+    /*
+    Destroys the node and frees it.
+    */
+    void destroy_node(Node* node)
+    {
+        NodeAllocator allocator(get_allocator());
+        NodeTraits::destroy(allocator, node);
+        NodeTraits::deallocate(allocator, node, 1);
+    }
+
     /*
     Find minimal element in the tree with given root.
     */
@@ -87,15 +133,14 @@ protected:
     }
 
     /*
-    Inserts a new node in the tree with a given value. Returns newly created node.
+    Inserts a new node in the tree with a given value and rebalances the path above it. Returns newly created node.
     */
-    Node* insert_helper(const T& value) 
+    Node* insert_helper(const T& value)
     {
-            
         if (empty())
         {
             ++mSize;
-            return mRoot = new Node(value);
+            return mRoot = create_node(value);
         }
 
         Node* cur = mRoot;
@@ -110,13 +155,135 @@ protected:
                 cur = cur->mLeft;
         }
 
+        Node* node = create_node(value, prev);
         if (prev->mData < value)
-            prev->mRight = new Node(value, prev);
+            prev->mRight = node;
         else
-            prev->mLeft = new Node(value, prev);
+            prev->mLeft = node;
 
         ++mSize;
-        return cur;
+        rebalance(prev);
+        return node;
+    }
+
+    static int height(const Node* node)
+    {
+        return node ? node->mHeight : 0;
+    }
+
+    static int balance_factor(const Node* node)
+    {
+        return height(node->mLeft) - height(node->mRight);
+    }
+
+    static std::size_t count(const Node* node)
+    {
+        return node ? node->mCount : 0;
+    }
+
+    /*
+    Recomputes the height and the element count of node from its children.
+    */
+    static void update_node(Node* node)
+    {
+        int left = height(node->mLeft);
+        int right = height(node->mRight);
+        node->mHeight = (left > right ? left : right) + 1;
+        node->mCount = count(node->mLeft) + count(node->mRight) + 1;
+    }
+
+    /*
+    Puts node in the place of old, as the child of old's parent (or as the root). Only the links to and from
+    the parent change.
+    */
+    void replace_child(Node* old, Node* node)
+    {
+        Node* parent = old->mParent;
+        if (parent == nullptr)
+            mRoot = node;
+        else if (parent->mLeft == old)
+            parent->mLeft = node;
+        else
+            parent->mRight = node;
+
+        if (node)
+            node->mParent = parent;
+    }
+
+    /*
+    Rotates the subtree rooted at node to the left: its right child becomes the root of the subtree.
+    Returns the new root.
+    */
+    Node* rotate_left(Node* node)
+    {
+        Node* right = node->mRight;
+        replace_child(node, right);
+
+        node->mRight = right->mLeft;
+        if (right->mLeft)
+            right->mLeft->mParent = node;
+
+        right->mLeft = node;
+        node->mParent = right;
+
+        update_node(node);
+        update_node(right);
+        return right;
+    }
+
+    /*
+    Rotates the subtree rooted at node to the right: its left child becomes the root of the subtree.
+    Returns the new root.
+    */
+    Node* rotate_right(Node* node)
+    {
+        Node* left = node->mLeft;
+        replace_child(node, left);
+
+        node->mLeft = left->mRight;
+        if (left->mRight)
+            left->mRight->mParent = node;
+
+        left->mRight = node;
+        node->mParent = left;
+
+        update_node(node);
+        update_node(left);
+        return left;
+    }
+
+    /*
+    Restores the heights and the AVL balance from node up to the root after a subtree below node grew or shrank
+    by one level. Once a node ends up balanced with its height unchanged nothing above can need rotating, and
+    only the element counts are fixed on the rest of the way.
+    */
+    void rebalance(Node* node)
+    {
+        for (; node; node = node->mParent)
+        {
+            int old_height = node->mHeight;
+            update_node(node);
+
+            int balance = balance_factor(node);
+            if (balance > 1)
+            {
+                if (balance_factor(node->mLeft) < 0)
+                    rotate_left(node->mLeft);
+                node = rotate_right(node);
+            }
+            else if (balance < -1)
+            {
+                if (balance_factor(node->mRight) > 0)
+                    rotate_right(node->mRight);
+                node = rotate_left(node);
+            }
+            else if (node->mHeight == old_height)
+                break;
+        }
+
+        if (node)
+            for (node = node->mParent; node; node = node->mParent)
+                node->mCount = count(node->mLeft) + count(node->mRight) + 1;
     }
 
     /*
@@ -142,103 +309,227 @@ protected:
 
     /*
     Erase given node from tree.
-    1. If node is the root:
-        1.1. If the root has no children, delete it and set mRoot to nullptr;
-        1.2. If the root has a right child, set the root to that child and hang the the left subtree (if it's not empty)
-        from the minimal element of the right subtree;
-        1.3. Otherwise root has only a left child, set the root to it.
-    2. If node is leaf (has no children), simply remove it from the tree.
-    3. If node has only one child, set that child as the new child for node's parent and delete the node.
-    4. If node has two children, find successor (predecessor) of the node. Copy it's data to the node and delete the successor (predecessor).
+    1. If node has at most one child, that child (or nothing) takes its place.
+    2. If node has two children, its successor (the minimum of the right subtree, which has no left child) is unlinked
+    from where it is and takes the place of node, children and height included.
+    Then the path from the lowest node whose subtree changed is rebalanced. No element is copied or moved.
     */
     void erase_helper(Node* node)
     {
-       if (node == mRoot)
-       {
-           if (mSize == 1)
-           {
-               delete node;
-               --mSize;
-               mRoot = nullptr;
-               return;
-           }
-           
-           Node* left = node->mLeft;
-           Node* right = node->mRight;
-
-           if (right)
-           {
-               if (left)
-               {
-                   Node* rmin = min_element(right);
-                   rmin->mLeft = left;
-
-                   left->mParent = rmin;
-               }
-               
-               mRoot = right;
-           }
-           else
-           {
-               mRoot = left;
-           }
-
-           mRoot->mParent = nullptr;
-           delete node;
-           --mSize;
-       }
-       
-       else if(node->mLeft == nullptr && node->mRight == nullptr)
-       {
-           Node* parent = node->mParent;
-
-           if (parent->mLeft == node)
-               parent->mLeft = nullptr;
-           else
-               parent->mRight = nullptr;
-
-           delete node;
-           --mSize;
-       }
-
-       else if (node->mLeft == nullptr || node->mRight == nullptr)
-       {
-           Node* child;
-           if (node->mLeft)
-               child = node->mLeft;
-           else
-               child = node->mRight;
-
-           if (node->mParent->mLeft == node)
-               node->mParent->mLeft = child;
-           else
-               node->mParent->mRight = child;
-
-           child->mParent = node->mParent;
-
-           delete node;
-           --mSize;
-       }
-
-       else
-       {
-           Node* next = successor(node);
-           node->mData = next->mData;
-           erase_helper(next);
-       }
-    }
-
-    /*
-    Delete the tree with given root recursively (to be used in destructor).
-    */
-    void delete_node_recursive(Node* node)
+        Node* changed;
+
+        if (node->mLeft == nullptr || node->mRight == nullptr)
+        {
+            changed = node->mParent;
+            replace_child(node, node->mLeft ? node->mLeft : node->mRight);
+        }
+        else
+        {
+            Node* next = min_element(node->mRight);
+            if (next == node->mRight)
+                changed = next;
+            else
+            {
+                changed = next->mParent;
+                changed->mLeft = next->mRight;
+                if (next->mRight)
+                    next->mRight->mParent = changed;
+
+                next->mRight = node->mRight;
+                node->mRight->mParent = next;
+            }
+
+            next->mLeft = node->mLeft;
+            node->mLeft->mParent = next;
+            next->mHeight = node->mHeight;
+            replace_child(node, next);
+        }
+
+        destroy_node(node);
+        --mSize;
+        rebalance(changed);
+    }
+
+    /*
+    Links the first count nodes of list, a chain through mRight in order, into a perfectly balanced tree hung from
+    parent, and advances list past them. Returns its root. The two subtrees of every node differ in size by at most
+    one, so the result is a valid AVL tree; the recursion is as deep as the tree. Allocates nothing and cannot throw.
+    */
+    static Node* link_balanced(Node*& list, std::size_t count, Node* parent)
     {
-        if (node == nullptr)
+        if (count == 0)
+            return nullptr;
+
+        std::size_t left_count = (count - 1) / 2;
+        Node* left = link_balanced(list, left_count, nullptr);
+
+        Node* node = list;
+        list = list->mRight;
+
+        node->mParent = parent;
+        node->mLeft = left;
+        if (left)
+            left->mParent = node;
+        node->mRight = link_balanced(list, count - 1 - left_count, node);
+        update_node(node);
+        return node;
+    }
+
+    /*
+    Fills the empty tree from [first, last). A sorted forward range is built in O(n): the nodes are created in order
+    into a list, then linked into a balanced tree at once. Anything else is inserted element by element.
+    */
+    template <typename InputIt>
+    void build_helper(InputIt first, InputIt last)
+    {
+        build_helper(first, last, typename std::iterator_traits<InputIt>::iterator_category());
+    }
+
+    template <typename ForwardIt>
+    void build_helper(ForwardIt first, ForwardIt last, std::forward_iterator_tag)
+    {
+        if (!std::is_sorted(first, last))
+        {
+            build_helper(first, last, std::input_iterator_tag());
             return;
+        }
+
+        Node* list = nullptr;
+        Node** tail = &list;
+        std::size_t count = 0;
+        try
+        {
+            for (; first != last; ++first, ++count)
+            {
+                *tail = create_node(*first);
+                tail = &(*tail)->mRight;
+            }
+        }
+        catch (...)
+        {
+            while (list)
+            {
+                Node* next = list->mRight;
+                destroy_node(list);
+                list = next;
+            }
+            throw;
+        }
+
+        mRoot = link_balanced(list, count, nullptr);
+        mSize = count;
+    }
+
+    template <typename InputIt>
+    void build_helper(InputIt first, InputIt last, std::input_iterator_tag)
+    {
+        for (; first != last; ++first)
+            insert_helper(*first);
+    }
+
+    /*
+    Copy assignment's part for allocators that propagate on it: takes over other's allocator, after dropping the
+    nodes first if the current allocator is the only one that can free them. Does nothing for the others.
+    */
+    void copy_allocator(const BST& other, std::true_type)
+    {
+        if (!std::allocator_traits<Allocator>::is_always_equal::value && get_allocator() != other.get_allocator())
+            clear();
+        static_cast<Allocator&>(*this) = static_cast<const Allocator&>(other);
+    }
+
+    void copy_allocator(const BST&, std::false_type)
+    {
+
+    }
+
+    /*
+    Move assignment's part that depends on the allocator: one that propagates is taken over from other. Returns
+    whether the nodes of other can be taken over, which is not the case for allocators that neither propagate nor
+    compare equal. The tree must be empty.
+    */
+    bool move_allocator(BST& other, std::true_type)
+    {
+        static_cast<Allocator&>(*this) = std::move(static_cast<Allocator&>(other));
+        return true;
+    }
+
+    bool move_allocator(BST& other, std::false_type)
+    {
+        return std::allocator_traits<Allocator>::is_always_equal::value || get_allocator() == other.get_allocator();
+    }
+
+    /*
+    Destroys the tree with given root without recursion, so however deep it is: while the node has a left child
+    it is rotated right, otherwise it is destroyed and its right child is next. Each node is touched at most twice.
+    */
+    void delete_tree(Node* node)
+    {
+        while (node)
+        {
+            if (Node* left = node->mLeft)
+            {
+                node->mLeft = left->mRight;
+                left->mRight = node;
+                node = left;
+            }
+            else
+            {
+                Node* right = node->mRight;
+                destroy_node(node);
+                node = right;
+            }
+        }
+    }
 
-        delete_node_recursive(node->mLeft);
-        delete_node_recursive(node->mRight);
-        delete node;
+    /*
+    Returns a copy of the tree with given root, of the same shape (heights and counts are copied, nothing is
+    rebalanced). Walks source and copy side by side in preorder without recursion; a child not copied yet is
+    what tells where to go next. On exception the partial copy is destroyed.
+    */
+    Node* clone_tree(const Node* root)
+    {
+        if (root == nullptr)
+            return nullptr;
+
+        Node* copy = create_node(root->mData);
+        copy->mHeight = root->mHeight;
+        copy->mCount = root->mCount;
+
+        const Node* src = root;
+        Node* dst = copy;
+        try
+        {
+            while (true)
+            {
+                if (src->mLeft && !dst->mLeft)
+                {
+                    src = src->mLeft;
+                    dst = dst->mLeft = create_node(src->mData, dst);
+                }
+                else if (src->mRight && !dst->mRight)
+                {
+                    src = src->mRight;
+                    dst = dst->mRight = create_node(src->mData, dst);
+                }
+                else
+                {
+                    if (src == root)
+                        break;
+                    src = src->mParent;
+                    dst = dst->mParent;
+                    continue;
+                }
+                dst->mHeight = src->mHeight;
+                dst->mCount = src->mCount;
+            }
+        }
+        catch (...)
+        {
+            delete_tree(copy);
+            throw;
+        }
+        return copy;
     }
 public:
     struct BST_iterator {
@@ -267,16 +558,6 @@ public:
             return mNode->mData;
         }
 
-        /*
-        Assignment operator overloading. Change underlying object to the rhs object.
-        */
-        BST_iterator& operator=(const BST_iterator& rhs) 
-        {
-            mNode = rhs.mNode;
-            mBst = rhs.mBst;
-            return *this;   
-        }
-
         /*
         Check if underlying objects are the same.
         */
@@ -343,8 +624,67 @@ public:
         BST* mBst;
     };
 
+    /*
+    Iterator of a const tree: a BST_iterator that only hands out const references to the elements.
+    */
+    struct BST_const_iterator {
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = int;
+        using pointer = const T*;
+        using reference = const T&;
+
+        BST_const_iterator() = default;
+
+        BST_const_iterator(const BST_iterator& it) : mIt(it)
+        {
+
+        }
+
+        const T& operator*() const
+        {
+            assert(mIt.mNode);
+            return mIt.mNode->mData;
+        }
+
+        bool operator==(const BST_const_iterator& rhs) const
+        {
+            return mIt == rhs.mIt;
+        }
+
+        bool operator!=(const BST_const_iterator& rhs) const
+        {
+            return mIt != rhs.mIt;
+        }
+
+        BST_const_iterator& operator++()
+        {
+            ++mIt;
+            return *this;
+        }
+
+        BST_const_iterator operator++(int)
+        {
+            return BST_const_iterator(mIt++);
+        }
+
+        BST_const_iterator& operator--()
+        {
+            --mIt;
+            return *this;
+        }
+
+        BST_const_iterator operator--(int)
+        {
+            return BST_const_iterator(mIt--);
+        }
+
+        BST_iterator mIt;
+    };
+
 protected:
     using iterator = BST_iterator;
+    using const_iterator = BST_const_iterator;
 
     /*
     min_element version with iterators.
@@ -381,18 +721,98 @@ public:
     /*
     Constructs an empty tree.
     */  
-    BST() : mRoot(nullptr), mSize(0)
+    BST() : Allocator(), mRoot(nullptr), mSize(0)
+    {
+
+    }
+
+    /*
+    Constructs an empty tree using allocator.
+    */
+    explicit BST(const Allocator& allocator) : Allocator(allocator), mRoot(nullptr), mSize(0)
+    {
+
+    }
+
+    /*
+    Constructs a tree from given elements. Sorted elements are built into a balanced tree in linear time.
+    */
+    BST(const std::initializer_list<T>& init, const Allocator& allocator = Allocator()) : BST(init.begin(), init.end(), allocator)
+    {
+
+    }
+
+    /*
+    Constructs a tree from the elements of [first, last). A sorted range of forward iterators is built into
+    a perfectly balanced tree in linear time; anything else costs an insert per element.
+    */
+    template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+    BST(InputIt first, InputIt last, const Allocator& allocator = Allocator()) : Allocator(allocator), mRoot(nullptr), mSize(0)
+    {
+        build_helper(first, last);
+    }
+
+    /*
+    Copy constructor. Constructs the tree with a copy of the contents of other, node for node.
+    */
+    BST(const BST& other) : Allocator(std::allocator_traits<Allocator>::select_on_container_copy_construction(other.get_allocator())),
+        mRoot(nullptr), mSize(0)
+    {
+        mRoot = clone_tree(other.mRoot);
+        mSize = other.mSize;
+    }
+
+    /*
+    Move constructor. Takes over the allocator and the nodes of other, which is left empty.
+    */
+    BST(BST&& other) noexcept : Allocator(std::move(static_cast<Allocator&>(other))), mRoot(other.mRoot), mSize(other.mSize)
+    {
+        other.mRoot = nullptr;
+        other.mSize = 0;
+    }
+
+    /*
+    Replaces the contents with a copy of the contents of other. If copying throws, *this is left unchanged
+    (unless the allocator had to be replaced, in which case it is left empty).
+    */
+    BST& operator=(const BST& other)
     {
+        if (this == &other)
+            return *this;
+
+        copy_allocator(other, typename std::allocator_traits<Allocator>::propagate_on_container_copy_assignment());
 
+        Node* copy = clone_tree(other.mRoot);
+        delete_tree(mRoot);
+        mRoot = copy;
+        mSize = other.mSize;
+        return *this;
     }
 
     /*
-    Constructs a tree from given elements.
+    Move assignment. Releases the current contents and takes over the nodes of other, which is left empty.
+    Nodes can only change hands when the allocators allow; otherwise they are copied.
     */
-    BST(const std::initializer_list<T>& init) : mRoot(nullptr), mSize(0)
+    BST& operator=(BST&& other) noexcept(std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value ||
+        std::allocator_traits<Allocator>::is_always_equal::value)
     {
-        for (const T& elem : init)
-            insert(elem);
+        if (this == &other)
+            return *this;
+
+        clear();
+        if (!move_allocator(other, typename std::allocator_traits<Allocator>::propagate_on_container_move_assignment()))
+        {
+            mRoot = clone_tree(other.mRoot);
+            mSize = other.mSize;
+            other.clear();
+            return *this;
+        }
+
+        mRoot = other.mRoot;
+        mSize = other.mSize;
+        other.mRoot = nullptr;
+        other.mSize = 0;
+        return *this;
     }
 
     /*
@@ -403,6 +823,138 @@ public:
         return iterator(find_helper(value), this);
     }
 
+    /*
+    Const version of find, returning an iterator that cannot modify the elements. The lookup itself never writes
+    to the tree.
+    */
+    const_iterator find(const T& value) const
+    {
+        return const_cast<BST*>(this)->find(value);
+    }
+
+    /*
+    Returns an iterator to the first element not less than value, or end() if there is none.
+    */
+    iterator lower_bound(const T& value)
+    {
+        Node* cur = mRoot;
+        Node* bound = nullptr;
+        while (cur)
+        {
+            if (cur->mData < value)
+                cur = cur->mRight;
+            else
+            {
+                bound = cur;
+                cur = cur->mLeft;
+            }
+        }
+        return iterator(bound, this);
+    }
+
+    /*
+    Const version of lower_bound.
+    */
+    const_iterator lower_bound(const T& value) const
+    {
+        return const_cast<BST*>(this)->lower_bound(value);
+    }
+
+    /*
+    Returns an iterator to the first element greater than value, or end() if there is none.
+    */
+    iterator upper_bound(const T& value)
+    {
+        Node* cur = mRoot;
+        Node* bound = nullptr;
+        while (cur)
+        {
+            if (value < cur->mData)
+            {
+                bound = cur;
+                cur = cur->mLeft;
+            }
+            else
+                cur = cur->mRight;
+        }
+        return iterator(bound, this);
+    }
+
+    /*
+    Const version of upper_bound.
+    */
+    const_iterator upper_bound(const T& value) const
+    {
+        return const_cast<BST*>(this)->upper_bound(value);
+    }
+
+    /*
+    Returns the range of elements equal to value, [lower_bound(value), upper_bound(value)).
+    */
+    std::pair<iterator, iterator> equal_range(const T& value)
+    {
+        return std::make_pair(lower_bound(value), upper_bound(value));
+    }
+
+    /*
+    Const version of equal_range.
+    */
+    std::pair<const_iterator, const_iterator> equal_range(const T& value) const
+    {
+        return std::make_pair(lower_bound(value), upper_bound(value));
+    }
+
+    /*
+    Returns an iterator to the element with k elements before it (the k-th smallest, counting from 0),
+    or end() if k is not less than size().
+    */
+    iterator select(std::size_t k)
+    {
+        Node* cur = mRoot;
+        while (cur)
+        {
+            std::size_t left = count(cur->mLeft);
+            if (k < left)
+                cur = cur->mLeft;
+            else if (k == left)
+                break;
+            else
+            {
+                k -= left + 1;
+                cur = cur->mRight;
+            }
+        }
+        return iterator(cur, this);
+    }
+
+    /*
+    Const version of select.
+    */
+    const_iterator select(std::size_t k) const
+    {
+        return const_cast<BST*>(this)->select(k);
+    }
+
+    /*
+    Returns the number of elements less than value, which is also the position lower_bound(value) has in the order.
+    */
+    std::size_t rank(const T& value) const
+    {
+        const Node* cur = mRoot;
+        std::size_t less = 0;
+        while (cur)
+        {
+            if (cur->mData < value)
+            {
+                less += count(cur->mLeft) + 1;
+                cur = cur->mRight;
+            }
+            else
+                cur = cur->mLeft;
+        }
+        return less;
+    }
+
     /*
     insert (insert_helper) version with iterators. As we let user to add more than one copy of the same value, second member of pair is always true.
     */
@@ -419,6 +971,26 @@ public:
         erase_helper(pos.mNode);
     }
 
+    /*
+    Erases the elements in [first, last). The nodes are unlinked one by one, in order, so rebalancing mostly stays
+    near the range; the whole tree is simply torn down. Iterators to the remaining elements stay valid.
+    */
+    void erase(iterator first, iterator last)
+    {
+        if (first == begin() && last == end())
+        {
+            clear();
+            return;
+        }
+
+        while (first != last)
+        {
+            Node* node = first.mNode;
+            ++first;
+            erase_helper(node);
+        }
+    }
+
     /*
     Returns an iterator to the first element of the BST.
     */
@@ -427,6 +999,14 @@ public:
         return iterator(min_element(mRoot), this);
     }
 
+    /*
+    Const version of begin.
+    */
+    const_iterator begin() const
+    {
+        return const_cast<BST*>(this)->begin();
+    }
+
     /*
     Returns an iterator to the element after the last element of the BST.
     */
@@ -435,6 +1015,14 @@ public:
         return iterator(nullptr, this);
     }
 
+    /*
+    Const version of end.
+    */
+    const_iterator end() const
+    {
+        return const_cast<BST*>(this)->end();
+    }
+
     /*
     Checks if the container has no elements.
     */
@@ -451,12 +1039,30 @@ public:
         return mSize;
     }
 
+    /*
+    Erases all elements from the tree.
+    */
+    void clear()
+    {
+        delete_tree(mRoot);
+        mRoot = nullptr;
+        mSize = 0;
+    }
+
+    /*
+    Returns a copy of the allocator.
+    */
+    Allocator get_allocator() const
+    {
+        return *this;
+    }
+
     /*
     Destructs the tree.
     */
     ~BST()
     {
-        delete_node_recursive(mRoot);
+        delete_tree(mRoot);
     }
 private:
     Node* mRoot;
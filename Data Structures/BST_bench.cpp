@@ -0,0 +1,71 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+#include "BST.h"
+
+/*
+Benchmark of BST against std::multiset on n int keys (1M by default), inserted in sorted then in random order:
+inserting all keys, finding each of them, then erasing half of them.
+Build and run:
+    g++ -std=c++17 -O2 BST_bench.cpp -o BST_bench
+    ./BST_bench [n]
+Only insert, find, erase(iterator) and end() are used, which every revision of BST has, so the program also
+times an older BST.h when built next to it. Before BST was balanced, sorted input made each operation linear:
+keep n around 20000 for that one.
+*/
+
+using Clock = std::chrono::steady_clock;
+
+static long hits = 0; // printed, so the lookups cannot be optimized away
+
+template <typename F>
+static double ms(F f)
+{
+    Clock::time_point start = Clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+template <typename Tree>
+static void run(const char* name, const std::vector<int>& keys)
+{
+    Tree tree;
+    double insert = ms([&] {
+        for (int key : keys)
+            tree.insert(key);
+    });
+    double find = ms([&] {
+        for (int key : keys)
+            hits += tree.find(key) != tree.end();
+    });
+    double erase = ms([&] {
+        for (std::size_t i = 0; i < keys.size() / 2; ++i)
+            tree.erase(tree.find(keys[i]));
+    });
+    std::printf("  %-14s %10.1f %10.1f %10.1f\n", name, insert, find, erase);
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t n = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    std::vector<int> sorted(n), random(n);
+    std::mt19937 rng(1);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        sorted[i] = static_cast<int>(i);
+        random[i] = static_cast<int>(rng());
+    }
+
+    for (const std::vector<int>* keys : {&sorted, &random})
+    {
+        std::printf("%zu %s keys, ms: %8s %10s %10s\n", n, keys == &sorted ? "sorted" : "random", "insert",
+                    "find", "erase half");
+        run<BST<int> >("BST", *keys);
+        run<std::multiset<int> >("std::multiset", *keys);
+    }
+    std::printf("hits: %ld\n", hits);
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+#include "BST.h"
+
+/*
+Benchmark of BST's range operations on n int keys (1M by default). Building from sorted keys: one insert per key
+against the range constructor, destruction included in both. Erasing k contiguous elements from a tree built in
+random order, for k from n/256 to n: one erase(it++) per element against erase(first, last).
+Build and run:
+    g++ -std=c++17 -O2 BST_range_bench.cpp -o BST_range_bench
+    ./BST_range_bench [n]
+*/
+
+using Clock = std::chrono::steady_clock;
+
+template <typename F>
+static double ms(F f)
+{
+    Clock::time_point start = Clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t n = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    std::vector<int> sorted(n);
+    for (std::size_t i = 0; i < n; ++i)
+        sorted[i] = static_cast<int>(i);
+
+    std::printf("building from %zu sorted keys:\n", n);
+    std::printf("  insert per key    %8.1f ms\n", ms([&] {
+        BST<int> tree;
+        for (int key : sorted)
+            tree.insert(key);
+    }));
+    std::printf("  range constructor %8.1f ms\n", ms([&] { BST<int> tree(sorted.begin(), sorted.end()); }));
+
+    std::vector<int> shuffled(sorted);
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(1));
+    std::printf("erasing k contiguous elements from %zu:\n", n);
+    std::printf("  %-8s %14s %14s\n", "k", "erase(it++)", "erase(f, l)");
+    for (std::size_t div : {256, 64, 16, 4, 2, 1})
+    {
+        std::size_t k = n / div;
+        std::size_t from = std::min(n / 4, n - k);
+        BST<int> a, b;
+        for (int key : shuffled)
+        {
+            a.insert(key);
+            b.insert(key);
+        }
+        auto firstA = a.begin();
+        auto firstB = b.begin();
+        std::advance(firstA, from);
+        std::advance(firstB, from);
+        auto lastA = firstA;
+        auto lastB = firstB;
+        std::advance(lastA, k);
+        std::advance(lastB, k);
+
+        double one = ms([&] {
+            while (firstA != lastA)
+                a.erase(firstA++);
+        });
+        double range = ms([&] { b.erase(firstB, lastB); });
+        if (a.size() != n - k || b.size() != n - k)
+        {
+            std::fprintf(stderr, "FAILED: size after erasing %zu elements\n", k);
+            return 1;
+        }
+        std::printf("  n/%-6zu %11.1f ms %11.1f ms\n", div, one, range);
+    }
+    return 0;
+}
@@ -0,0 +1,59 @@
+#include <chrono>
+#include <cstdio>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+#include "BST.h"
+
+/*
+Benchmark of BST's order statistics on a tree of n random int keys (1M by default): n select(k) and n rank(value)
+calls at random positions, against reaching 100 random positions by advancing an iterator from begin().
+Build and run:
+    g++ -std=c++17 -O2 BST_rank_bench.cpp -o BST_rank_bench
+    ./BST_rank_bench [n]
+The cost of keeping subtree counts on insert and erase is measured by BST_bench.cpp, built against this BST.h and
+against the one before counts were added.
+*/
+
+using Clock = std::chrono::steady_clock;
+
+static long checksum = 0; // printed, so the work cannot be optimized away
+
+template <typename F>
+static double ms(F f)
+{
+    Clock::time_point start = Clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t n = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    std::vector<int> keys(n);
+    std::mt19937 rng(1);
+    for (int& key : keys)
+        key = static_cast<int>(rng());
+    BST<int> tree(keys.begin(), keys.end());
+
+    std::printf("%zu random keys, total ms:\n", n);
+    std::printf("  %zu select(k)   %10.1f\n", n, ms([&] {
+        for (std::size_t i = 0; i < n; ++i)
+            checksum += *tree.select(rng() % n);
+    }));
+    std::printf("  %zu rank(value) %10.1f\n", n, ms([&] {
+        for (std::size_t i = 0; i < n; ++i)
+            checksum += tree.rank(keys[rng() % n]);
+    }));
+    std::printf("  100 advances    %10.1f\n", ms([&] {
+        for (int i = 0; i < 100; ++i)
+        {
+            auto it = tree.begin();
+            std::advance(it, rng() % n);
+            checksum += *it;
+        }
+    }));
+    std::printf("checksum: %ld\n", checksum);
+    return 0;
+}
@@ -0,0 +1,269 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Allocators.h"
+#include "BST.h"
+
+/*
+Stress test of BST teardown and copying on large trees, through the public interface only. Trees of n elements
+(2M by default) are filled in ascending, descending and random order; ascending inserts are what used to produce
+a vine as deep as the tree is large. Each is copied, assigned, moved, rebuilt from its own range, partly erased,
+cleared and destroyed, checking the contents after every step and that no element is leaked or destroyed twice.
+Copies that throw and node pools are covered on smaller trees.
+Build and run:
+    g++ -std=c++17 -O2 BST_stress.cpp -o BST_stress && ./BST_stress [n]
+Checks stay on with NDEBUG. Prints the time of each step and "ok" at the end; any failure exits with status 1.
+*/
+
+/*
+Element that counts live instances and can be made to throw on the k-th copy from now.
+*/
+struct Tracked {
+    static long live;
+    static long throwAt;
+
+    int mValue;
+
+    Tracked(int value) : mValue(value)
+    {
+        ++live;
+    }
+
+    Tracked(const Tracked& other) : mValue(other.mValue)
+    {
+        if (throwAt >= 0 && throwAt-- == 0)
+            throw std::runtime_error("copy failed");
+        ++live;
+    }
+
+    Tracked& operator=(const Tracked&) = default;
+
+    ~Tracked()
+    {
+        --live;
+    }
+
+    bool operator<(const Tracked& other) const
+    {
+        return mValue < other.mValue;
+    }
+};
+
+long Tracked::live = 0;
+long Tracked::throwAt = -1;
+
+using Clock = std::chrono::steady_clock;
+
+static void check(bool condition, const char* what)
+{
+    if (!condition)
+    {
+        std::fprintf(stderr, "FAILED: %s\n", what);
+        std::exit(1);
+    }
+}
+
+/*
+Runs f and prints how long it took.
+*/
+template <typename F>
+static void timed(const char* what, F f)
+{
+    Clock::time_point start = Clock::now();
+    f();
+    std::printf("  %-36s %8.1f ms\n", what, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+}
+
+/*
+Checks that tree holds exactly the elements of sorted, in order, and that select and rank agree with them at a
+sample of positions.
+*/
+template <typename Tree>
+static void checkContents(Tree& tree, const std::vector<int>& sorted, const char* what)
+{
+    check(tree.size() == sorted.size(), what);
+    check(tree.empty() == sorted.empty(), what);
+    std::size_t i = 0;
+    for (auto it = tree.begin(); it != tree.end(); ++it, ++i)
+        check(i < sorted.size() && (*it).mValue == sorted[i], what);
+    check(i == sorted.size(), what);
+
+    std::size_t step = sorted.size() / 1000 + 1;
+    for (std::size_t k = 0; k < sorted.size(); k += step)
+    {
+        check((*tree.select(k)).mValue == sorted[k], what);
+        std::size_t below = std::lower_bound(sorted.begin(), sorted.end(), sorted[k]) - sorted.begin();
+        check(tree.rank(Tracked(sorted[k])) == below, what);
+    }
+}
+
+/*
+Fills a tree from values in their order and runs every teardown and copy path on it.
+*/
+static void stressLarge(const char* order, const std::vector<int>& values)
+{
+    std::printf("%s order, %zu elements\n", order, values.size());
+    std::vector<int> sorted(values);
+    std::sort(sorted.begin(), sorted.end());
+    {
+        BST<Tracked> tree;
+        timed("insert", [&] {
+            for (int value : values)
+                tree.insert(Tracked(value));
+        });
+        checkContents(tree, sorted, "filled tree");
+
+        {
+            BST<Tracked>* copy = nullptr;
+            timed("copy construct", [&] { copy = new BST<Tracked>(tree); });
+            checkContents(*copy, sorted, "copy");
+            copy->insert(Tracked(-1));
+            check(tree.size() == sorted.size() && copy->size() == sorted.size() + 1, "copy shares nodes with original");
+            timed("destroy copy", [&] { delete copy; });
+            check(Tracked::live == static_cast<long>(sorted.size()), "destroying copy");
+        }
+
+        BST<Tracked> assigned{Tracked(1), Tracked(2), Tracked(3)};
+        timed("copy assign", [&] { assigned = tree; });
+        checkContents(assigned, sorted, "copy assignment");
+        assigned = static_cast<const BST<Tracked>&>(assigned);
+        checkContents(assigned, sorted, "self assignment");
+
+        BST<Tracked> moved(std::move(assigned));
+        check(assigned.empty() && assigned.begin() == assigned.end(), "moved from tree not empty");
+        assigned.insert(Tracked(5));
+        check(assigned.size() == 1, "moved from tree unusable");
+        assigned = std::move(moved);
+        check(moved.empty(), "move assigned from tree not empty");
+        checkContents(assigned, sorted, "move assignment");
+
+        timed("erase first half", [&] { assigned.erase(assigned.begin(), assigned.select(sorted.size() / 2)); });
+        checkContents(assigned, std::vector<int>(sorted.begin() + sorted.size() / 2, sorted.end()), "range erase");
+        timed("clear", [&] { assigned.clear(); });
+        check(assigned.empty() && assigned.begin() == assigned.end(), "clear");
+        check(Tracked::live == static_cast<long>(sorted.size()), "clear leaked");
+
+        BST<Tracked>* rebuilt = nullptr;
+        timed("build from sorted range", [&] { rebuilt = new BST<Tracked>(tree.begin(), tree.end()); });
+        checkContents(*rebuilt, sorted, "range construction");
+        timed("destroy rebuilt", [&] { delete rebuilt; });
+        timed("erase everything", [&] { tree.erase(tree.begin(), tree.end()); });
+        check(tree.empty(), "erase everything");
+
+        BST<Tracked>* refilled = new BST<Tracked>();
+        for (int value : values)
+            refilled->insert(Tracked(value));
+        timed("destroy refilled", [&] { delete refilled; });
+    }
+    check(Tracked::live == 0, "elements leaked or destroyed twice");
+}
+
+/*
+Copies that throw at every possible point must free what they copied and leave the target as it was.
+*/
+static void stressThrowingCopies()
+{
+    const int n = 200;
+    BST<Tracked> tree;
+    std::vector<int> sorted;
+    for (int i = 0; i < n; ++i)
+    {
+        tree.insert(Tracked(i * 37 % n));
+        sorted.push_back(i);
+    }
+    BST<Tracked> target{Tracked(-3), Tracked(-2), Tracked(-1)};
+    long live = Tracked::live;
+
+    for (long k = 0; k <= n; ++k)
+    {
+        bool thrown = false;
+        Tracked::throwAt = k;
+        try
+        {
+            BST<Tracked> copy(tree);
+        }
+        catch (const std::runtime_error&)
+        {
+            thrown = true;
+        }
+        Tracked::throwAt = -1;
+        check(thrown == (k < n) && Tracked::live == live, "throwing copy construction");
+
+        Tracked::throwAt = k;
+        try
+        {
+            target = tree;
+            Tracked::throwAt = -1;
+            check(k >= n, "copy assignment did not throw");
+            checkContents(target, sorted, "copy assignment after throws");
+            target = BST<Tracked>{Tracked(-3), Tracked(-2), Tracked(-1)};
+        }
+        catch (const std::runtime_error&)
+        {
+            check(k < n, "copy assignment threw");
+            checkContents(target, std::vector<int>{-3, -2, -1}, "target of throwing copy assignment changed");
+        }
+        Tracked::throwAt = -1;
+        check(Tracked::live == live, "throwing copy assignment leaked");
+    }
+    std::printf("throwing copies ok\n");
+}
+
+/*
+Copies and moves between trees on different node pools, which must not take over each other's nodes.
+*/
+static void stressPools()
+{
+    const std::size_t n = 100000;
+    NodePool first, second;
+    using Tree = BST<Tracked, PoolAllocator<Tracked> >;
+    {
+        Tree a{PoolAllocator<Tracked>(first)}, b{PoolAllocator<Tracked>(second)};
+        std::vector<int> sorted;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            a.insert(Tracked(static_cast<int>(i)));
+            sorted.push_back(static_cast<int>(i));
+        }
+
+        Tree copy(a);
+        check(first.in_use() == 2 * n, "pool copy");
+        b = std::move(a);
+        checkContents(b, sorted, "move assignment between pools");
+        check(a.empty() && first.in_use() == n && second.in_use() == n, "move assignment between pools");
+        b = copy;
+        checkContents(b, sorted, "copy assignment between pools");
+        check(second.in_use() == n, "copy assignment between pools");
+        b.clear();
+        check(second.in_use() == 0, "clear on pool");
+    }
+    check(first.in_use() == 0 && second.in_use() == 0 && Tracked::live == 0, "pool trees leaked");
+    std::printf("node pools ok\n");
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t n = argc > 1 ? std::stoul(argv[1]) : 2000000;
+
+    std::vector<int> values(n);
+    for (std::size_t i = 0; i < n; ++i)
+        values[i] = static_cast<int>(i);
+    stressLarge("ascending", values);
+    std::reverse(values.begin(), values.end());
+    stressLarge("descending", values);
+    std::mt19937 rng(1);
+    for (int& value : values)
+        value = static_cast<int>(rng() % (n / 2 + 1)); // duplicates too
+    stressLarge("random", values);
+
+    stressThrowingCopies();
+    stressPools();
+    std::printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,744 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <cassert>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BTREE_HAS_SSE2 1
+#endif
+
+/*
+Search within one sorted node. Binary search through operator< in general; int keys are compared four at a time with
+SSE2 where it is available, a node being a handful of cache lines that are read whole anyway.
+*/
+template <typename T>
+struct BTreeSearch {
+    /*
+    Number of keys less than value, that is, the index of the first key not less than value.
+    */
+    static int lower(const T* keys, int count, const T& value)
+    {
+        return static_cast<int>(std::lower_bound(keys, keys + count, value) - keys);
+    }
+
+    /*
+    Number of keys not greater than value, that is, the index of the first key greater than value.
+    */
+    static int upper(const T* keys, int count, const T& value)
+    {
+        return static_cast<int>(std::upper_bound(keys, keys + count, value) - keys);
+    }
+};
+
+#ifdef BTREE_HAS_SSE2
+template <>
+struct BTreeSearch<int> {
+    static_assert(sizeof(int) == 4, "four keys per vector");
+
+    static int popcount4(int mask)
+    {
+        return static_cast<int>((0x4332322132212110ull >> (mask * 4)) & 0xF);
+    }
+
+    /*
+    Counts the keys for which the lanes of cmp(keys, value) are set. As the keys are sorted, the set lanes are a
+    prefix and the scan stops at the first vector that is not all set. Lanes past count are masked out.
+    */
+    template <typename Compare>
+    static int count_prefix(const int* keys, int count, int value, Compare cmp)
+    {
+        const __m128i v = _mm_set1_epi32(value);
+        int i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i));
+            int mask = _mm_movemask_ps(_mm_castsi128_ps(cmp(k, v)));
+            if (mask != 0xF)
+                return i + popcount4(mask);
+        }
+        for (; i < count && cmp(keys[i], value); ++i)
+            ;
+        return i;
+    }
+
+    static int lower(const int* keys, int count, int value)
+    {
+        struct Less {
+            __m128i operator()(__m128i k, __m128i v) const { return _mm_cmplt_epi32(k, v); }
+            bool operator()(int k, int v) const { return k < v; }
+        };
+        return count_prefix(keys, count, value, Less());
+    }
+
+    static int upper(const int* keys, int count, int value)
+    {
+        struct NotGreater {
+            __m128i operator()(__m128i k, __m128i v) const { return _mm_andnot_si128(_mm_cmpgt_epi32(k, v), _mm_set1_epi32(-1)); }
+            bool operator()(int k, int v) const { return !(v < k); }
+        };
+        return count_prefix(keys, count, value, NotGreater());
+    }
+};
+#endif
+
+/*
+Ordered container allowing duplicates, with the interface of BST, stored as a B+ tree: elements sit sorted in leaves
+of about NodeBytes bytes that are linked for iteration, inner nodes hold only separators and child pointers. For small
+T this means many elements per cache line and a tree a few levels deep, where BST has one element and three pointers
+per node and a level per comparison.
+Unlike BST, insert and erase shift elements within and between nodes, so they invalidate all iterators.
+Nodes come from Allocator, a standard allocator rebound to the node types.
+*/
+template <typename T, std::size_t NodeBytes = 512, typename Allocator = std::allocator<T> >
+class BTree : private Allocator {
+private:
+    struct Inner;
+
+    struct Node {
+        Inner* mParent = nullptr;
+        int mCount = 0; // of keys
+        bool mIsLeaf = false;
+    };
+
+    struct Leaf;
+
+    static constexpr int LeafHeader = sizeof(Node) + 2 * sizeof(Leaf*);
+    static constexpr int InnerHeader = sizeof(Node) + sizeof(Node*);
+public:
+    /*
+    Keys per leaf and separators per inner node fitting NodeBytes, at least 3.
+    */
+    static constexpr int LeafCapacity = static_cast<int>(NodeBytes) > LeafHeader + 3 * static_cast<int>(sizeof(T))
+        ? (static_cast<int>(NodeBytes) - LeafHeader) / static_cast<int>(sizeof(T)) : 3;
+    static constexpr int InnerCapacity = static_cast<int>(NodeBytes) > InnerHeader + 3 * static_cast<int>(sizeof(T) + sizeof(Node*))
+        ? (static_cast<int>(NodeBytes) - InnerHeader) / static_cast<int>(sizeof(T) + sizeof(Node*)) : 3;
+private:
+    // fewest keys a node other than the root may have
+    static constexpr int LeafMin = LeafCapacity / 2;
+    static constexpr int InnerMin = (InnerCapacity - 1) / 2;
+
+    struct Leaf : Node {
+        Leaf* mPrev = nullptr;
+        Leaf* mNext = nullptr;
+        alignas(T) unsigned char mStorage[LeafCapacity * sizeof(T)];
+
+        T* keys()
+        {
+            return reinterpret_cast<T*>(mStorage);
+        }
+    };
+
+    struct Inner : Node {
+        Node* mChildren[InnerCapacity + 1];
+        alignas(T) unsigned char mStorage[InnerCapacity * sizeof(T)];
+
+        T* keys()
+        {
+            return reinterpret_cast<T*>(mStorage);
+        }
+    };
+
+    using Search = BTreeSearch<T>;
+
+    Node* mRoot;
+    Leaf* mFirst;
+    Leaf* mLast;
+    std::size_t mSize;
+
+    template <typename N>
+    N* create_node()
+    {
+        using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<N>;
+        NodeAllocator allocator(get_allocator());
+        N* node = std::allocator_traits<NodeAllocator>::allocate(allocator, 1);
+        new (node) N; // the key storage is left uninitialized
+        node->mIsLeaf = std::is_same<N, Leaf>::value;
+        return node;
+    }
+
+    /*
+    Frees a node whose keys are already destroyed.
+    */
+    template <typename N>
+    void destroy_node(N* node)
+    {
+        using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<N>;
+        NodeAllocator allocator(get_allocator());
+        node->~N();
+        std::allocator_traits<NodeAllocator>::deallocate(allocator, node, 1);
+    }
+
+    static Leaf* as_leaf(Node* node)
+    {
+        return static_cast<Leaf*>(node);
+    }
+
+    static Inner* as_inner(Node* node)
+    {
+        return static_cast<Inner*>(node);
+    }
+
+    static bool is_full(const Node* node)
+    {
+        return node->mCount == (node->mIsLeaf ? LeafCapacity : InnerCapacity);
+    }
+
+    /*
+    Inserts value at pos into the count constructed keys at keys, which have room for one more.
+    */
+    template <typename U>
+    static void insert_key(T* keys, int count, int pos, U&& value)
+    {
+        if (pos == count)
+        {
+            new (keys + count) T(std::forward<U>(value));
+            return;
+        }
+
+        new (keys + count) T(std::move(keys[count - 1]));
+        for (int i = count - 1; i > pos; --i)
+            keys[i] = std::move(keys[i - 1]);
+        keys[pos] = std::forward<U>(value);
+    }
+
+    /*
+    Removes the key at pos from the count constructed keys at keys.
+    */
+    static void erase_key(T* keys, int count, int pos)
+    {
+        std::move(keys + pos + 1, keys + count, keys + pos);
+        keys[count - 1].~T();
+    }
+
+    /*
+    Moves count keys at from to the uninitialized keys at to, destroying the originals.
+    */
+    static void move_keys(T* from, int count, T* to)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            new (to + i) T(std::move(from[i]));
+            from[i].~T();
+        }
+    }
+
+    static void destroy_keys(T* keys, int count)
+    {
+        for (int i = 0; i < count; ++i)
+            keys[i].~T();
+    }
+
+    static int child_index(const Inner* parent, const Node* child)
+    {
+        int i = 0;
+        while (parent->mChildren[i] != child)
+            ++i;
+        return i;
+    }
+
+    /*
+    Splits the full child i of parent, which has room for one more separator, into two halves.
+    A leaf gives the right half's first key as separator, an inner node moves its middle separator up.
+    */
+    void split_child(Inner* parent, int i)
+    {
+        Node* child = parent->mChildren[i];
+        Node* right;
+
+        if (child->mIsLeaf)
+        {
+            Leaf* left = as_leaf(child);
+            Leaf* leaf = create_node<Leaf>();
+            int keep = LeafCapacity / 2;
+            move_keys(left->keys() + keep, left->mCount - keep, leaf->keys());
+            leaf->mCount = left->mCount - keep;
+            left->mCount = keep;
+
+            leaf->mPrev = left;
+            leaf->mNext = left->mNext;
+            if (left->mNext)
+                left->mNext->mPrev = leaf;
+            else
+                mLast = leaf;
+            left->mNext = leaf;
+
+            insert_key(parent->keys(), parent->mCount, i, leaf->keys()[0]);
+            right = leaf;
+        }
+        else
+        {
+            Inner* left = as_inner(child);
+            Inner* inner = create_node<Inner>();
+            int mid = InnerCapacity / 2;
+            move_keys(left->keys() + mid + 1, left->mCount - mid - 1, inner->keys());
+            inner->mCount = left->mCount - mid - 1;
+            for (int c = 0; c <= inner->mCount; ++c)
+            {
+                inner->mChildren[c] = left->mChildren[mid + 1 + c];
+                inner->mChildren[c]->mParent = inner;
+            }
+
+            insert_key(parent->keys(), parent->mCount, i, std::move(left->keys()[mid]));
+            left->keys()[mid].~T();
+            left->mCount = mid;
+            right = inner;
+        }
+
+        for (int c = parent->mCount + 1; c > i + 1; --c)
+            parent->mChildren[c] = parent->mChildren[c - 1];
+        parent->mChildren[i + 1] = right;
+        right->mParent = parent;
+        ++parent->mCount;
+    }
+
+    /*
+    Removes separator i and child i + 1 from parent.
+    */
+    static void remove_child(Inner* parent, int i)
+    {
+        erase_key(parent->keys(), parent->mCount, i);
+        for (int c = i + 1; c < parent->mCount; ++c)
+            parent->mChildren[c] = parent->mChildren[c + 1];
+        --parent->mCount;
+    }
+
+    /*
+    Refills leaf, which has fallen below LeafMin keys: borrows a key from a sibling that can spare one, otherwise
+    merges with a sibling and fixes up the parent, which lost a child.
+    */
+    void fix_leaf(Leaf* leaf)
+    {
+        Inner* parent = leaf->mParent;
+        int i = child_index(parent, leaf);
+        Leaf* left = i > 0 ? as_leaf(parent->mChildren[i - 1]) : nullptr;
+        Leaf* right = i < parent->mCount ? as_leaf(parent->mChildren[i + 1]) : nullptr;
+
+        if (left && left->mCount > LeafMin)
+        {
+            insert_key(leaf->keys(), leaf->mCount++, 0, std::move(left->keys()[left->mCount - 1]));
+            left->keys()[--left->mCount].~T();
+            parent->keys()[i - 1] = leaf->keys()[0];
+            return;
+        }
+
+        if (right && right->mCount > LeafMin)
+        {
+            new (leaf->keys() + leaf->mCount++) T(std::move(right->keys()[0]));
+            erase_key(right->keys(), right->mCount--, 0);
+            parent->keys()[i] = right->keys()[0];
+            return;
+        }
+
+        if (left)
+        {
+            merge_leaves(left, leaf);
+            remove_child(parent, i - 1);
+        }
+        else
+        {
+            merge_leaves(leaf, right);
+            remove_child(parent, i);
+        }
+        fix_inner(parent);
+    }
+
+    /*
+    Appends the keys of right to left and frees right.
+    */
+    void merge_leaves(Leaf* left, Leaf* right)
+    {
+        move_keys(right->keys(), right->mCount, left->keys() + left->mCount);
+        left->mCount += right->mCount;
+
+        left->mNext = right->mNext;
+        if (right->mNext)
+            right->mNext->mPrev = left;
+        else
+            mLast = left;
+        destroy_node(right);
+    }
+
+    /*
+    Refills inner after it lost a child, as fix_leaf does for leaves; separators rotate through the parent.
+    A root left with a single child is replaced by that child.
+    */
+    void fix_inner(Inner* inner)
+    {
+        if (inner == mRoot)
+        {
+            if (inner->mCount == 0)
+            {
+                mRoot = inner->mChildren[0];
+                mRoot->mParent = nullptr;
+                destroy_node(inner);
+            }
+            return;
+        }
+
+        if (inner->mCount >= InnerMin)
+            return;
+
+        Inner* parent = inner->mParent;
+        int i = child_index(parent, inner);
+        Inner* left = i > 0 ? as_inner(parent->mChildren[i - 1]) : nullptr;
+        Inner* right = i < parent->mCount ? as_inner(parent->mChildren[i + 1]) : nullptr;
+
+        if (left && left->mCount > InnerMin)
+        {
+            insert_key(inner->keys(), inner->mCount, 0, std::move(parent->keys()[i - 1]));
+            for (int c = inner->mCount + 1; c > 0; --c)
+                inner->mChildren[c] = inner->mChildren[c - 1];
+            inner->mChildren[0] = left->mChildren[left->mCount];
+            inner->mChildren[0]->mParent = inner;
+            ++inner->mCount;
+
+            parent->keys()[i - 1] = std::move(left->keys()[left->mCount - 1]);
+            left->keys()[--left->mCount].~T();
+            return;
+        }
+
+        if (right && right->mCount > InnerMin)
+        {
+            new (inner->keys() + inner->mCount) T(std::move(parent->keys()[i]));
+            inner->mChildren[inner->mCount + 1] = right->mChildren[0];
+            inner->mChildren[inner->mCount + 1]->mParent = inner;
+            ++inner->mCount;
+
+            parent->keys()[i] = std::move(right->keys()[0]);
+            erase_key(right->keys(), right->mCount, 0);
+            for (int c = 0; c < right->mCount; ++c)
+                right->mChildren[c] = right->mChildren[c + 1];
+            --right->mCount;
+            return;
+        }
+
+        if (left)
+        {
+            merge_inners(left, inner, parent, i - 1);
+            remove_child(parent, i - 1);
+        }
+        else
+        {
+            merge_inners(inner, right, parent, i);
+            remove_child(parent, i);
+        }
+        fix_inner(parent);
+    }
+
+    /*
+    Appends separator sep of parent and the keys and children of right to left, and frees right.
+    */
+    void merge_inners(Inner* left, Inner* right, Inner* parent, int sep)
+    {
+        new (left->keys() + left->mCount) T(parent->keys()[sep]);
+        move_keys(right->keys(), right->mCount, left->keys() + left->mCount + 1);
+        for (int c = 0; c <= right->mCount; ++c)
+        {
+            left->mChildren[left->mCount + 1 + c] = right->mChildren[c];
+            right->mChildren[c]->mParent = left;
+        }
+        left->mCount += right->mCount + 1;
+        destroy_node(right);
+    }
+
+    /*
+    Destroys the subtree rooted at node. Its depth is the height of the tree, a few levels.
+    */
+    void delete_subtree(Node* node)
+    {
+        if (!node->mIsLeaf)
+        {
+            Inner* inner = as_inner(node);
+            for (int c = 0; c <= inner->mCount; ++c)
+                delete_subtree(inner->mChildren[c]);
+            destroy_keys(inner->keys(), inner->mCount);
+            destroy_node(inner);
+        }
+        else
+        {
+            destroy_keys(as_leaf(node)->keys(), node->mCount);
+            destroy_node(as_leaf(node));
+        }
+    }
+public:
+    struct BTree_iterator {
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T*;
+        using reference = T&;
+
+        /*
+        Constructor for iterator. A null leaf is the end.
+        */
+        explicit BTree_iterator(Leaf* leaf = nullptr, int index = 0, BTree* tree = nullptr) : mLeaf(leaf), mIndex(index), mTree(tree)
+        {
+
+        }
+
+        /*
+        Dereference operator overloading. Returns underlying objects data.
+        If object is not valid throw assertion.
+        */
+        T& operator*() const
+        {
+            assert(mLeaf);
+            return mLeaf->keys()[mIndex];
+        }
+
+        T* operator->() const
+        {
+            assert(mLeaf);
+            return mLeaf->keys() + mIndex;
+        }
+
+        bool operator==(const BTree_iterator& rhs) const
+        {
+            return mLeaf == rhs.mLeaf && mIndex == rhs.mIndex && mTree == rhs.mTree;
+        }
+
+        bool operator!=(const BTree_iterator& rhs) const
+        {
+            return !(*this == rhs);
+        }
+
+        /*
+        Moves to the next element, to the next leaf past the last one of a leaf. If object is not valid throw assertion.
+        */
+        BTree_iterator& operator++()
+        {
+            assert(mLeaf);
+            if (++mIndex == mLeaf->mCount)
+            {
+                mLeaf = mLeaf->mNext;
+                mIndex = 0;
+            }
+            return *this;
+        }
+
+        BTree_iterator operator++(int)
+        {
+            BTree_iterator temp = *this;
+            operator++();
+            return temp;
+        }
+
+        /*
+        Moves to the previous element; end() moves to the last one. If there is none throw assertion.
+        */
+        BTree_iterator& operator--()
+        {
+            if (mLeaf == nullptr)
+            {
+                mLeaf = mTree->mLast;
+                assert(mLeaf);
+                mIndex = mLeaf->mCount;
+            }
+            else if (mIndex == 0)
+            {
+                mLeaf = mLeaf->mPrev;
+                assert(mLeaf);
+                mIndex = mLeaf->mCount;
+            }
+            --mIndex;
+            return *this;
+        }
+
+        BTree_iterator operator--(int)
+        {
+            BTree_iterator temp = *this;
+            operator--();
+            return temp;
+        }
+
+        Leaf* mLeaf;
+        int mIndex;
+        BTree* mTree;
+    };
+
+    using iterator = BTree_iterator;
+
+    /*
+    Constructs an empty tree.
+    */
+    BTree() : Allocator(), mRoot(nullptr), mFirst(nullptr), mLast(nullptr), mSize(0)
+    {
+
+    }
+
+    /*
+    Constructs an empty tree using allocator.
+    */
+    explicit BTree(const Allocator& allocator) : Allocator(allocator), mRoot(nullptr), mFirst(nullptr), mLast(nullptr), mSize(0)
+    {
+
+    }
+
+    /*
+    Constructs a tree from given elements.
+    */
+    BTree(const std::initializer_list<T>& init, const Allocator& allocator = Allocator()) : BTree(allocator)
+    {
+        for (const T& elem : init)
+            insert(elem);
+    }
+
+    BTree(const BTree&) = delete;
+    BTree& operator=(const BTree&) = delete;
+
+    /*
+    Returns an iterator to the first element not less than value, or end().
+    */
+    iterator lower_bound(const T& value)
+    {
+        if (mRoot == nullptr)
+            return end();
+
+        Node* node = mRoot;
+        while (!node->mIsLeaf)
+        {
+            Inner* inner = as_inner(node);
+            node = inner->mChildren[Search::lower(inner->keys(), inner->mCount, value)];
+        }
+
+        // all keys of this leaf may be less, the answer is then the first key of the next one
+        Leaf* leaf = as_leaf(node);
+        int pos = Search::lower(leaf->keys(), leaf->mCount, value);
+        if (pos == leaf->mCount)
+            return iterator(leaf->mNext, 0, this);
+        return iterator(leaf, pos, this);
+    }
+
+    /*
+    Finds an element equal to value, returns end() if there is none.
+    */
+    iterator find(const T& value)
+    {
+        iterator it = lower_bound(value);
+        if (it != end() && value < *it)
+            return end();
+        return it;
+    }
+
+    /*
+    Inserts value after the elements equal to it. Full nodes met on the way down are split first, so the leaf
+    reached has room. As we let user to add more than one copy of the same value, second member of pair is always true.
+    */
+    std::pair<iterator, bool> insert(const T& value)
+    {
+        if (mRoot == nullptr)
+            mRoot = mFirst = mLast = create_node<Leaf>();
+
+        if (is_full(mRoot))
+        {
+            Inner* root = create_node<Inner>();
+            root->mChildren[0] = mRoot;
+            mRoot->mParent = root;
+            mRoot = root;
+            split_child(root, 0);
+        }
+
+        Node* node = mRoot;
+        while (!node->mIsLeaf)
+        {
+            Inner* inner = as_inner(node);
+            int i = Search::upper(inner->keys(), inner->mCount, value);
+            if (is_full(inner->mChildren[i]))
+            {
+                split_child(inner, i);
+                if (!(value < inner->keys()[i]))
+                    ++i;
+            }
+            node = inner->mChildren[i];
+        }
+
+        Leaf* leaf = as_leaf(node);
+        int pos = Search::upper(leaf->keys(), leaf->mCount, value);
+        insert_key(leaf->keys(), leaf->mCount, pos, value);
+        ++leaf->mCount;
+        ++mSize;
+        return std::make_pair(iterator(leaf, pos, this), true);
+    }
+
+    /*
+    Erases the element at pos. Leaves and inner nodes that become less than half full borrow from or merge with
+    a sibling.
+    */
+    void erase(iterator pos)
+    {
+        assert(pos.mLeaf && pos.mTree == this);
+        Leaf* leaf = pos.mLeaf;
+        erase_key(leaf->keys(), leaf->mCount, pos.mIndex);
+        --leaf->mCount;
+        --mSize;
+
+        if (leaf == mRoot)
+        {
+            if (leaf->mCount == 0)
+            {
+                destroy_node(leaf);
+                mRoot = mFirst = mLast = nullptr;
+            }
+            return;
+        }
+
+        if (leaf->mCount < LeafMin)
+            fix_leaf(leaf);
+    }
+
+    /*
+    Returns an iterator to the first element of the tree.
+    */
+    iterator begin()
+    {
+        return iterator(mFirst, 0, this);
+    }
+
+    /*
+    Returns an iterator to the element after the last element of the tree.
+    */
+    iterator end()
+    {
+        return iterator(nullptr, 0, this);
+    }
+
+    /*
+    Checks if the container has no elements.
+    */
+    bool empty() const
+    {
+        return mSize == 0;
+    }
+
+    /*
+    Returns the number of elements in the container.
+    */
+    std::size_t size() const
+    {
+        return mSize;
+    }
+
+    /*
+    Returns a copy of the allocator.
+    */
+    Allocator get_allocator() const
+    {
+        return *this;
+    }
+
+    /*
+    Destructs the tree.
+    */
+    ~BTree()
+    {
+        if (mRoot)
+            delete_subtree(mRoot);
+    }
+};
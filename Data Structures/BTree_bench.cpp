@@ -0,0 +1,88 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+#include "BST.h"
+#include "BTree.h"
+
+/*
+Benchmark of BTree against BST and std::multiset on n random int keys (1M by default): inserting all keys, n finds
+of which half hit, iterating over the whole container, then erasing half of the keys. BTree runs with 256, 512 and
+1024-byte nodes, and once more with a key type wrapping int, which takes the generic binary search within nodes
+instead of the SSE2 one.
+Build and run:
+    g++ -std=c++17 -O2 BTree_bench.cpp -o BTree_bench
+    ./BTree_bench [n]
+*/
+
+using Clock = std::chrono::steady_clock;
+
+static long checksum = 0; // printed, so the work cannot be optimized away
+
+/*
+An int that BTreeSearch does not specialize.
+*/
+struct ScalarKey {
+    int mValue;
+
+    ScalarKey(int value) : mValue(value) {}
+    bool operator<(const ScalarKey& rhs) const { return mValue < rhs.mValue; }
+    bool operator==(const ScalarKey& rhs) const { return mValue == rhs.mValue; }
+};
+
+template <typename F>
+static double ms(F f)
+{
+    Clock::time_point start = Clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static int value(int key) { return key; }
+static int value(const ScalarKey& key) { return key.mValue; }
+
+template <typename Tree>
+static void run(const char* name, const std::vector<int>& keys, const std::vector<int>& probes)
+{
+    Tree tree;
+    double insert = ms([&] {
+        for (int key : keys)
+            tree.insert(key);
+    });
+    double find = ms([&] {
+        for (int key : probes)
+            checksum += tree.find(key) != tree.end();
+    });
+    double iterate = ms([&] {
+        for (auto it = tree.begin(); it != tree.end(); ++it)
+            checksum += value(*it);
+    });
+    double erase = ms([&] {
+        for (std::size_t i = 0; i < keys.size() / 2; ++i)
+            tree.erase(tree.find(keys[i]));
+    });
+    std::printf("  %-22s %8.1f %8.1f %8.1f %10.1f\n", name, insert, find, iterate, erase);
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t n = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    std::vector<int> keys(n), probes(n);
+    std::mt19937 rng(1);
+    for (int& key : keys)
+        key = static_cast<int>(rng() & 0x7fffffff);
+    for (std::size_t i = 0; i < n; ++i)
+        probes[i] = i % 2 ? keys[rng() % n] : static_cast<int>(rng() & 0x7fffffff);
+
+    std::printf("%zu random keys, ms: %9s %8s %8s %10s\n", n, "insert", "find", "iterate", "erase half");
+    run<BST<int> >("BST", keys, probes);
+    run<std::multiset<int> >("std::multiset", keys, probes);
+    run<BTree<int, 256> >("BTree<int, 256>", keys, probes);
+    run<BTree<int, 512> >("BTree<int, 512>", keys, probes);
+    run<BTree<int, 1024> >("BTree<int, 1024>", keys, probes);
+    run<BTree<ScalarKey, 512> >("BTree<ScalarKey, 512>", keys, probes);
+    std::printf("checksum: %ld\n", checksum);
+    return 0;
+}
@@ -0,0 +1,290 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include "BST.h"
+
+/*
+BST shared by many reader threads and updated by rare writers, using the Left-Right technique: the container keeps
+two copies of the tree. Readers always use the copy no writer touches. A writer changes the other copy, points
+new readers at it, waits until the last reader of the old copy is gone and repeats the change there.
+Readers never block, retry or write to a tree. Each read costs two atomic updates of a counter shared with only a
+few threads. Writers are serialized by a mutex. A write costs its BST operation twice plus waiting for the reads
+that are already under way. Memory is twice that of a BST.
+Reads go through a ReadGuard, which offers the lookup and iterator part of the BST interface. Its iterators stay
+valid while the guard lives; those of two guards may belong to different copies and must not be mixed. A writer
+waits for every guard taken before it started, so keep guards short lived, and never write from a thread holding
+one (it would wait for itself).
+*/
+template <typename T, typename Allocator = std::allocator<T> >
+class ConcurrentBST {
+public:
+    using Tree = BST<T, Allocator>;
+    using iterator = typename Tree::BST_iterator;
+    using const_iterator = typename Tree::BST_const_iterator;
+private:
+    static const std::size_t ReaderSlots = 16; // counters per version, spread over threads
+
+    struct alignas(64) ReaderCount {
+        std::atomic<std::size_t> mReaders{0};
+    };
+
+    Tree mTrees[2];
+    std::atomic<int> mReadIndex; // copy new readers use
+    std::atomic<int> mVersion; // counters new readers register in
+    ReaderCount mCounts[2][ReaderSlots];
+    std::mutex mWriteMutex;
+
+    /*
+    Returns the counter slot of the calling thread. Threads get slots round robin, so up to ReaderSlots readers
+    never share a cache line.
+    */
+    static std::size_t reader_slot()
+    {
+        static std::atomic<std::size_t> next{0};
+        thread_local std::size_t slot = next.fetch_add(1, std::memory_order_relaxed) % ReaderSlots;
+        return slot;
+    }
+
+    /*
+    Waits until no reader is registered in the counters of given version.
+    */
+    void wait_for_readers(int version) const
+    {
+        for (const ReaderCount& count : mCounts[version])
+            while (count.mReaders.load() != 0)
+                std::this_thread::yield();
+    }
+
+    /*
+    Makes sure no reader uses the copy readers have just been moved away from. New readers register in the other
+    version first, so the wait for the old version's readers cannot be starved by readers that keep arriving.
+    */
+    void wait_for_old_readers()
+    {
+        int version = mVersion.load(std::memory_order_relaxed);
+        wait_for_readers(1 - version);
+        mVersion.store(1 - version);
+        wait_for_readers(version);
+    }
+
+    /*
+    Makes the copy at index a copy of the other one, after a change failed on it. No reader may be using it.
+    */
+    void resync(int index) noexcept
+    {
+        mTrees[index] = mTrees[1 - index];
+    }
+public:
+    /*
+    Read access to the tree, for as long as the guard lives. Provides the lookup and iteration functions of BST, on
+    a const tree: its iterators only give const references, since other readers share the copy.
+    */
+    class ReadGuard {
+    public:
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+        ReadGuard(ReadGuard&& other) noexcept : mCount(other.mCount), mTree(other.mTree)
+        {
+            other.mCount = nullptr;
+        }
+
+        const_iterator find(const T& value) const
+        {
+            return mTree->find(value);
+        }
+
+        const_iterator lower_bound(const T& value) const
+        {
+            return mTree->lower_bound(value);
+        }
+
+        const_iterator upper_bound(const T& value) const
+        {
+            return mTree->upper_bound(value);
+        }
+
+        std::pair<const_iterator, const_iterator> equal_range(const T& value) const
+        {
+            return mTree->equal_range(value);
+        }
+
+        const_iterator select(std::size_t k) const
+        {
+            return mTree->select(k);
+        }
+
+        std::size_t rank(const T& value) const
+        {
+            return mTree->rank(value);
+        }
+
+        const_iterator begin() const
+        {
+            return mTree->begin();
+        }
+
+        const_iterator end() const
+        {
+            return mTree->end();
+        }
+
+        bool empty() const
+        {
+            return mTree->empty();
+        }
+
+        std::size_t size() const
+        {
+            return mTree->size();
+        }
+
+        /*
+        Unregisters the reader, letting writers waiting for it go on.
+        */
+        ~ReadGuard()
+        {
+            if (mCount)
+                mCount->fetch_sub(1, std::memory_order_release);
+        }
+    private:
+        friend class ConcurrentBST;
+
+        ReadGuard(std::atomic<std::size_t>* count, const Tree* tree) : mCount(count), mTree(tree)
+        {
+
+        }
+
+        std::atomic<std::size_t>* mCount;
+        const Tree* mTree;
+    };
+
+    /*
+    Constructs an empty container using allocator.
+    */
+    explicit ConcurrentBST(const Allocator& allocator = Allocator())
+        : mTrees{ Tree(allocator), Tree(allocator) }, mReadIndex(0), mVersion(0)
+    {
+
+    }
+
+    /*
+    Constructs the container from the elements of [first, last), as BST does.
+    */
+    template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+    ConcurrentBST(InputIt first, InputIt last, const Allocator& allocator = Allocator())
+        : mTrees{ Tree(first, last, allocator), Tree(allocator) }, mReadIndex(0), mVersion(0)
+    {
+        mTrees[1] = mTrees[0];
+    }
+
+    ConcurrentBST(const std::initializer_list<T>& init, const Allocator& allocator = Allocator())
+        : ConcurrentBST(init.begin(), init.end(), allocator)
+    {
+
+    }
+
+    ConcurrentBST(const ConcurrentBST&) = delete;
+    ConcurrentBST& operator=(const ConcurrentBST&) = delete;
+
+    /*
+    Registers the calling thread as a reader and returns the guard giving access to the current tree.
+    Never blocks.
+    */
+    ReadGuard read()
+    {
+        std::atomic<std::size_t>& count = mCounts[mVersion.load()][reader_slot()].mReaders;
+        count.fetch_add(1);
+        return ReadGuard(&count, &mTrees[mReadIndex.load()]);
+    }
+
+    /*
+    Applies f (called with a Tree&) to the contents; writers run one at a time. f is called once per copy and must
+    do the same to both, so it can only depend on its arguments and the tree. If f throws, the copy it threw on is
+    made a copy of the other one again (the program terminates if that fails too) and the exception goes on: the
+    contents are those from before the call if it threw on the first copy, those after it if on the second.
+    */
+    template <typename F>
+    void modify(F f)
+    {
+        std::lock_guard<std::mutex> lock(mWriteMutex);
+        int index = mReadIndex.load(std::memory_order_relaxed);
+        try
+        {
+            f(mTrees[1 - index]);
+        }
+        catch (...)
+        {
+            resync(1 - index);
+            throw;
+        }
+        mReadIndex.store(1 - index);
+        wait_for_old_readers();
+
+        try
+        {
+            f(mTrees[index]);
+        }
+        catch (...)
+        {
+            resync(index);
+            throw;
+        }
+    }
+
+    /*
+    Inserts value.
+    */
+    void insert(const T& value)
+    {
+        modify([&value](Tree& tree) { tree.insert(value); });
+    }
+
+    /*
+    Erases one element equal to value, if any. Returns whether there was one.
+    */
+    bool erase(const T& value)
+    {
+        bool erased = false;
+        modify([&value, &erased](Tree& tree) {
+            iterator pos = tree.find(value);
+            erased = pos != tree.end();
+            if (erased)
+                tree.erase(pos);
+        });
+        return erased;
+    }
+
+    /*
+    Erases all elements.
+    */
+    void clear()
+    {
+        modify([](Tree& tree) { tree.clear(); });
+    }
+
+    /*
+    Returns a copy of the allocator.
+    */
+    Allocator get_allocator() const
+    {
+        return mTrees[0].get_allocator();
+    }
+
+    /*
+    Destructs the container. No reader may be left.
+    */
+    ~ConcurrentBST()
+    {
+        for (const auto& counts : mCounts)
+            for (const ReaderCount& count : counts)
+                assert(count.mReaders.load() == 0);
+    }
+};
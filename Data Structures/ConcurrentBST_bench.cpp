@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ConcurrentBST.h"
+
+/*
+Benchmark of concurrent lookups scaling from 1 to max_readers reader threads (the hardware threads by default,
+doubling each step), on a tree of n random keys (1M by default). ConcurrentBST is compared with a BST behind a
+std::shared_mutex (shared lock per lookup) and one behind a std::mutex. Each configuration runs for ms
+milliseconds (1000 by default), first with readers only, then with a writer inserting one key per millisecond.
+Build and run:
+    g++ -std=c++17 -O2 -pthread ConcurrentBST_bench.cpp -o ConcurrentBST_bench
+    ./ConcurrentBST_bench [n] [max_readers] [ms]
+Prints million lookups per second, summed over the readers, and the total hits so the lookups cannot be
+optimized away. Scaling needs as many cores as readers; beyond that the readers share them.
+*/
+
+using Clock = std::chrono::steady_clock;
+
+static std::vector<int> keys;
+static std::atomic<long> hits{0};
+
+/*
+Runs threads readers calling lookup(key) on random keys for duration, with a writer calling insert(key) every
+millisecond if writer is set. Returns the number of lookups per second, in millions.
+*/
+template <typename Lookup, typename Insert>
+static double run(int threads, bool writer, std::chrono::milliseconds duration, Lookup lookup, Insert insert)
+{
+    std::atomic<bool> stop{false};
+    std::atomic<long> lookups{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < threads; ++t)
+        readers.emplace_back([&, t] {
+            std::mt19937 rng(t);
+            long done = 0, found = 0;
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                for (int i = 0; i < 64; ++i)
+                    found += lookup(keys[rng() % keys.size()]);
+                done += 64;
+            }
+            lookups += done;
+            hits += found;
+        });
+
+    std::thread writerThread;
+    if (writer)
+        writerThread = std::thread([&] {
+            std::mt19937 rng(~0u);
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                insert(static_cast<int>(rng()));
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+
+    Clock::time_point start = Clock::now();
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    for (std::thread& reader : readers)
+        reader.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    if (writer)
+        writerThread.join();
+    return lookups / seconds / 1e6;
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t n = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    unsigned hardware = std::thread::hardware_concurrency();
+    int maxReaders = argc > 2 ? std::stoi(argv[2]) : (hardware ? static_cast<int>(hardware) : 1);
+    std::chrono::milliseconds duration(argc > 3 ? std::stoi(argv[3]) : 1000);
+
+    std::mt19937 rng(1);
+    keys.resize(n);
+    for (int& key : keys)
+        key = static_cast<int>(rng());
+
+    ConcurrentBST<int> concurrent(keys.begin(), keys.end());
+    BST<int> shared(keys.begin(), keys.end());
+    std::shared_mutex sharedMutex;
+    BST<int> locked(keys.begin(), keys.end());
+    std::mutex mutex;
+
+    std::printf("%zu keys, %u hardware threads, M lookups/s\n", n, hardware);
+    for (bool writer : {false, true})
+    {
+        std::printf(writer ? "with a writer (1 insert/ms):\n" : "readers only:\n");
+        std::printf("  %7s %14s %14s %14s\n", "readers", "ConcurrentBST", "shared_mutex", "mutex");
+        for (int threads = 1;; threads = std::min(threads * 2, maxReaders))
+        {
+            double a = run(threads, writer, duration, [&](int key) {
+                ConcurrentBST<int>::ReadGuard guard = concurrent.read();
+                return guard.find(key) != guard.end();
+            }, [&](int key) { concurrent.insert(key); });
+            double b = run(threads, writer, duration, [&](int key) {
+                std::shared_lock<std::shared_mutex> lock(sharedMutex);
+                return shared.find(key) != shared.end();
+            }, [&](int key) {
+                std::unique_lock<std::shared_mutex> lock(sharedMutex);
+                shared.insert(key);
+            });
+            double c = run(threads, writer, duration, [&](int key) {
+                std::lock_guard<std::mutex> lock(mutex);
+                return locked.find(key) != locked.end();
+            }, [&](int key) {
+                std::lock_guard<std::mutex> lock(mutex);
+                locked.insert(key);
+            });
+            std::printf("  %7d %14.2f %14.2f %14.2f\n", threads, a, b, c);
+            if (threads == maxReaders)
+                break;
+        }
+    }
+    std::printf("hits: %ld\n", hits.load());
+    return 0;
+}
@@ -1,8 +1,15 @@
+#pragma once
 #include <cassert>
 #include <algorithm>
-
-template <typename T>
-class List {
+#include <memory>
+#include <utility>
+
+/*
+Nodes come from Allocator, a standard allocator rebound to the node type.
+The allocator is a (private, so empty ones take no room) base of the container.
+*/
+template <typename T, typename Allocator = std::allocator<T> >
+class List : private Allocator {
 private:
     /*
     Class for representing each element in the container.
@@ -125,10 +132,43 @@ private:
 
     typedef List_iterator iterator;
 private:
+    using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using NodeTraits = std::allocator_traits<NodeAllocator>;
+
     Node* mHead;
     Node* mTail;
     std::size_t mSize;
 
+    /*
+    Allocates a node and constructs it from args.
+    */
+    template <typename... Args>
+    Node* create_node(Args&&... args)
+    {
+        NodeAllocator allocator(get_allocator());
+        Node* node = NodeTraits::allocate(allocator, 1);
+        try
+        {
+            NodeTraits::construct(allocator, node, std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            NodeTraits::deallocate(allocator, node, 1);
+            throw;
+        }
+        return node;
+    }
+
+    /*
+    Destroys the node and frees it.
+    */
+    void destroy_node(Node* node)
+    {
+        NodeAllocator allocator(get_allocator());
+        NodeTraits::destroy(allocator, node);
+        NodeTraits::deallocate(allocator, node, 1);
+    }
+
     /*
     Check if given position iterator valid. To be used for bounding checks in insert and erase.
     */
@@ -143,7 +183,15 @@ public:
     /*
     Default constructor for List.
     */
-    List() : mHead(nullptr), mTail(nullptr), mSize(0)
+    List() : Allocator(), mHead(nullptr), mTail(nullptr), mSize(0)
+    {
+
+    }
+
+    /*
+    Constructs an empty list using allocator.
+    */
+    explicit List(const Allocator& allocator) : Allocator(allocator), mHead(nullptr), mTail(nullptr), mSize(0)
     {
 
     }
@@ -151,7 +199,8 @@ public:
     /*
     Constructor for List.
     */
-    List(std::size_t count, const T& value = {}) : mHead(nullptr), mTail(nullptr), mSize(0)
+    List(std::size_t count, const T& value = {}, const Allocator& allocator = Allocator())
+        : Allocator(allocator), mHead(nullptr), mTail(nullptr), mSize(0)
     {  
         for (std::size_t i = 0; i < count; ++i)
         	push_back(value);
@@ -162,7 +211,7 @@ public:
     */
     void push_back(const T& elem)
     {
-        Node* newNode = new Node(elem, nullptr, mTail);
+        Node* newNode = create_node(elem, nullptr, mTail);
 
         if (empty())
         {
@@ -186,13 +235,13 @@ public:
         --mSize;
         if (mSize == 0)
         {
-            delete mTail;
+            destroy_node(mTail);
             mHead = mTail = nullptr;
             return;
         }
 
         mTail = mTail->mPrev;
-        delete mTail->mNext;
+        destroy_node(mTail->mNext);
         mTail->mNext = nullptr;
     }
 
@@ -201,7 +250,7 @@ public:
     */
     void push_front(const T& elem)
     {
-        Node* newNode = new Node(elem, mHead);
+        Node* newNode = create_node(elem, mHead);
         
         if (empty())
         {
@@ -225,13 +274,13 @@ public:
         --mSize;
         if (mSize == 0)
         {
-            delete mHead;
+            destroy_node(mHead);
             mHead = mTail = nullptr;
             return;
         }
 
         mHead = mHead->mNext;
-        delete mHead->mPrev;
+        destroy_node(mHead->mPrev);
         mHead->mPrev = nullptr;
     }
 
@@ -339,7 +388,7 @@ public:
         ++mSize;
         Node* next = pos.mNode;
         Node* prev = pos.mNode->mPrev;
-        Node* newNode = new Node(value, next, prev);
+        Node* newNode = create_node(value, next, prev);
 
         next->mPrev = newNode;
         prev->mNext = newNode;
@@ -372,7 +421,7 @@ public:
         next->mPrev = prev;
         prev->mNext = next;
     
-        delete pos.mNode; 
+        destroy_node(pos.mNode);
     }
 
     /*
@@ -421,6 +470,14 @@ public:
         return mSize;
     }
 
+    /*
+    Returns a copy of the allocator.
+    */
+    Allocator get_allocator() const
+    {
+        return *this;
+    }
+
     /*
     Destructs the list.
     */
@@ -0,0 +1,474 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "Vector.h"
+
+/*
+Vector with room for N elements inside the object itself. Up to N elements no heap memory is used at all;
+beyond that the elements move to heap storage that grows like Vector's, and stay there.
+The interface is the one of Vector, and so is the handling of Allocator, which provides the heap storage and
+constructs and destroys the elements, the inline ones included.
+*/
+template <typename T, std::size_t N = 8, typename Allocator = std::allocator<T> >
+class SmallVector : private Allocator {
+private:
+	static_assert(N > 0, "use Vector for no inline capacity");
+
+	using Storage = Vector<T, Allocator>; // allocate, deallocate, destroy and relocate
+	using Traits = std::allocator_traits<Allocator>;
+
+	std::size_t mSize;
+	std::size_t mCapacity;
+	T* mArr; // points to mInline while the elements fit there
+	alignas(T) unsigned char mInline[N * sizeof(T)];
+
+	T* inlineStorage()
+	{
+		return reinterpret_cast<T*>(mInline);
+	}
+
+	Allocator& allocator()
+	{
+		return *this;
+	}
+
+	const Allocator& allocator() const
+	{
+		return *this;
+	}
+
+	/*
+	Frees heap storage, if any, and points the container back at its inline buffer. The elements must be gone.
+	*/
+	void resetStorage()
+	{
+		if (!is_small())
+			Storage::deallocate(allocator(), mArr, mCapacity);
+		mArr = inlineStorage();
+		mCapacity = N;
+	}
+
+	/*
+	Copy assignment's part for allocators that propagate on it: drops the contents and the storage, which belong to
+	the current allocator, and takes over other's. Does nothing for the others.
+	*/
+	void copyAllocator(const SmallVector& other, std::true_type)
+	{
+		clear();
+		resetStorage();
+		allocator() = other.allocator();
+	}
+
+	void copyAllocator(const SmallVector&, std::false_type)
+	{
+
+	}
+
+	/*
+	Move assignment's part for allocators that propagate on it: frees the storage and takes over other's allocator.
+	Does nothing for the others. The elements must be gone.
+	*/
+	void moveAllocator(SmallVector& other, std::true_type)
+	{
+		resetStorage();
+		allocator() = std::move(other.allocator());
+	}
+
+	void moveAllocator(SmallVector&, std::false_type)
+	{
+
+	}
+
+	/*
+	Moves the elements to heap storage for new_capacity elements, constructing one more element at position mSize
+	from args first (args may refer to an element of the old storage).
+	*/
+	template <typename... Args>
+	void grow(std::size_t new_capacity, Args&&... args)
+	{
+		T* newArr = Storage::allocate(allocator(), new_capacity);
+		try
+		{
+			Traits::construct(allocator(), newArr + mSize, std::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			Storage::deallocate(allocator(), newArr, new_capacity);
+			throw;
+		}
+
+		try
+		{
+			Storage::relocate(allocator(), mArr, mSize, newArr);
+		}
+		catch (...)
+		{
+			Traits::destroy(allocator(), newArr + mSize);
+			Storage::deallocate(allocator(), newArr, new_capacity);
+			throw;
+		}
+
+		resetStorage();
+		mArr = newArr;
+		mCapacity = new_capacity;
+		++mSize;
+	}
+
+	/*
+	Takes the elements of other, which is left empty: its heap storage if it has some and the allocators allow,
+	otherwise the elements one by one. *this must be empty.
+	*/
+	void take(SmallVector& other)
+	{
+		if (!other.is_small() && (Traits::is_always_equal::value || allocator() == other.allocator()))
+		{
+			resetStorage();
+			mArr = other.mArr;
+			mCapacity = other.mCapacity;
+			mSize = other.mSize;
+			other.mArr = other.inlineStorage();
+			other.mCapacity = N;
+			other.mSize = 0;
+			return;
+		}
+
+		reserve(other.mSize);
+		Storage::relocate(allocator(), other.mArr, other.mSize, mArr);
+		mSize = other.mSize;
+		other.mSize = 0;
+	}
+public:
+	using value_type = T;
+	using size_type = std::size_t;
+	using difference_type = std::ptrdiff_t;
+	using reference = T&;
+	using const_reference = const T&;
+	using pointer = T*;
+	using const_pointer = const T*;
+	using iterator = T*;
+	using const_iterator = const T*;
+	using reverse_iterator = std::reverse_iterator<iterator>;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+	/*
+	Default constructor. Constructs an empty container using its inline storage.
+	*/
+	SmallVector() : SmallVector(Allocator())
+	{
+
+	}
+
+	/*
+	Constructs an empty container using allocator for heap storage.
+	*/
+	explicit SmallVector(const Allocator& allocator) : Allocator(allocator), mSize(0), mCapacity(N), mArr(inlineStorage())
+	{
+
+	}
+
+	/*
+	Constructs the container with count copies of elements with default value.
+	*/
+	SmallVector(std::size_t count, const Allocator& allocator = Allocator()) : SmallVector(allocator)
+	{
+		resize(count);
+	}
+
+	/*
+	Copy constructor. Constructs the container with the copy of the contents of other.
+	*/
+	SmallVector(const SmallVector& other) : SmallVector(Traits::select_on_container_copy_construction(other.allocator()))
+	{
+		reserve(other.mSize);
+		for (const T& elem : other)
+			emplace_back(elem);
+	}
+
+	/*
+	Move constructor. Takes over the allocator and the heap storage of other, or moves its inline elements.
+	other is left empty.
+	*/
+	SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible<T>::value) : SmallVector(other.allocator())
+	{
+		take(other);
+	}
+
+	/*
+	Returns a reference to the element at specified location pos.
+	If user tries to access element out of bounds throw assertion.
+	*/
+	T& operator[](std::size_t pos)
+	{
+		assert(pos < mSize);
+		return mArr[pos];
+	}
+
+	const T& operator[](std::size_t pos) const
+	{
+		assert(pos < mSize);
+		return mArr[pos];
+	}
+
+	/*
+	Replaces the contents with a copy of the contents of other.
+	*/
+	SmallVector& operator=(const SmallVector& other)
+	{
+		if (this == &other)
+			return *this;
+
+		copyAllocator(other, typename Traits::propagate_on_container_copy_assignment());
+
+		SmallVector copy(allocator());
+		copy.reserve(other.mSize);
+		for (const T& elem : other)
+			copy.emplace_back(elem);
+		return *this = std::move(copy);
+	}
+
+	/*
+	Move assignment. Releases the current contents and takes over those of other, which is left empty.
+	*/
+	SmallVector& operator=(SmallVector&& other) noexcept(std::is_nothrow_move_constructible<T>::value &&
+		(Traits::propagate_on_container_move_assignment::value || Traits::is_always_equal::value))
+	{
+		if (this == &other)
+			return *this;
+
+		clear();
+		moveAllocator(other, typename Traits::propagate_on_container_move_assignment());
+		take(other);
+		return *this;
+	}
+
+	/*
+	Checks if the contents are equal, that is, both have the same number of elements and
+	each element in current object compares equal with the element in other at the same position.
+	*/
+	bool operator==(const SmallVector& other) const
+	{
+		if (mSize != other.mSize)
+			return false;
+
+		for (std::size_t i = 0; i < mSize; ++i)
+			if (mArr[i] != other.mArr[i])
+				return false;
+		return true;
+	}
+
+	/*
+	Makes room for at least new_capacity elements. Storage only moves to the heap once new_capacity exceeds N.
+	*/
+	void reserve(std::size_t new_capacity)
+	{
+		if (new_capacity <= mCapacity)
+			return;
+
+		T* newArr = Storage::allocate(allocator(), new_capacity);
+		try
+		{
+			Storage::relocate(allocator(), mArr, mSize, newArr);
+		}
+		catch (...)
+		{
+			Storage::deallocate(allocator(), newArr, new_capacity);
+			throw;
+		}
+
+		resetStorage();
+		mArr = newArr;
+		mCapacity = new_capacity;
+	}
+
+	/*
+	Appends the given element value to the end of the container.
+	*/
+	void push_back(const T& elem)
+	{
+		emplace_back(elem);
+	}
+
+	void push_back(T&& elem)
+	{
+		emplace_back(std::move(elem));
+	}
+
+	/*
+	Appends a new element constructed in place from args. Returns a reference to it.
+	*/
+	template <typename... Args>
+	T& emplace_back(Args&&... args)
+	{
+		if (mSize < mCapacity)
+		{
+			Traits::construct(allocator(), mArr + mSize, std::forward<Args>(args)...);
+			++mSize;
+		}
+		else
+			grow(mCapacity * 2, std::forward<Args>(args)...);
+		return mArr[mSize - 1];
+	}
+
+	/*
+	Resizes the container to contain count elements, destroying the surplus or appending default-inserted elements.
+	*/
+	void resize(std::size_t count)
+	{
+		reserve(count);
+
+		if (count < mSize)
+			Storage::destroy(allocator(), mArr + count, mArr + mSize);
+		for (; mSize < count; ++mSize)
+			Traits::construct(allocator(), mArr + mSize);
+		mSize = count;
+	}
+
+	/*
+	Removes the last element of the container.
+	If user tries to call pop_back on an empty container throw assertion.
+	*/
+	void pop_back()
+	{
+		assert(mSize);
+		Traits::destroy(allocator(), mArr + --mSize);
+	}
+
+	/*
+	Erases all elements from the container. Heap storage, if any, is kept for reuse.
+	*/
+	void clear()
+	{
+		Storage::destroy(allocator(), mArr, mArr + mSize);
+		mSize = 0;
+	}
+
+	/*
+	Returns reference to the last element in the container.
+	If user tries to call back on an empty container throw assertion.
+	*/
+	T& back()
+	{
+		assert(mSize);
+		return mArr[mSize - 1];
+	}
+
+	const T& back() const
+	{
+		assert(mSize);
+		return mArr[mSize - 1];
+	}
+
+	T* data()
+	{
+		return mArr;
+	}
+
+	const T* data() const
+	{
+		return mArr;
+	}
+
+	iterator begin()
+	{
+		return mArr;
+	}
+
+	const_iterator begin() const
+	{
+		return mArr;
+	}
+
+	const_iterator cbegin() const
+	{
+		return mArr;
+	}
+
+	iterator end()
+	{
+		return mArr + mSize;
+	}
+
+	const_iterator end() const
+	{
+		return mArr + mSize;
+	}
+
+	const_iterator cend() const
+	{
+		return mArr + mSize;
+	}
+
+	reverse_iterator rbegin()
+	{
+		return reverse_iterator(end());
+	}
+
+	const_reverse_iterator rbegin() const
+	{
+		return const_reverse_iterator(end());
+	}
+
+	reverse_iterator rend()
+	{
+		return reverse_iterator(begin());
+	}
+
+	const_reverse_iterator rend() const
+	{
+		return const_reverse_iterator(begin());
+	}
+
+	/*
+	Checks if the container has no elements.
+	*/
+	bool empty() const
+	{
+		return mSize == 0;
+	}
+
+	/*
+	Returns the number of elements in the container.
+	*/
+	std::size_t size() const
+	{
+		return mSize;
+	}
+
+	/*
+	Returns the number of elements the container has room for, N while it is still using its inline storage.
+	*/
+	std::size_t capacity() const
+	{
+		return mCapacity;
+	}
+
+	/*
+	Returns a copy of the allocator.
+	*/
+	Allocator get_allocator() const
+	{
+		return allocator();
+	}
+
+	/*
+	Checks whether the elements are still stored inside the object.
+	*/
+	bool is_small() const
+	{
+		return mArr == reinterpret_cast<const T*>(mInline);
+	}
+
+	/*
+	Destructs the container. The destructors of the elements are called and heap storage, if any, is deallocated.
+	*/
+	~SmallVector()
+	{
+		clear();
+		resetStorage();
+	}
+};
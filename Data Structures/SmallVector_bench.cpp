@@ -0,0 +1,60 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+#include "SmallVector.h"
+#include "Vector.h"
+
+/*
+Benchmark of many short-lived small containers: 2^20 times, build a container of six ints by push_back and read
+it back, with SmallVector<int, 8>, Vector<int> and std::vector<int>. Each case runs three times and the best time
+is printed.
+Build and run:
+	g++ -std=c++17 -O2 SmallVector_bench.cpp -o SmallVector_bench && ./SmallVector_bench
+*/
+
+using Clock = std::chrono::steady_clock;
+
+static std::size_t checksum = 0; // printed, so the work cannot be optimized away
+
+/*
+Runs f three times and returns the best time in milliseconds.
+*/
+template <typename F>
+static double best(F f)
+{
+	double result = 0;
+	for (int run = 0; run < 3; ++run)
+	{
+		Clock::time_point start = Clock::now();
+		f();
+		double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		result = run == 0 ? ms : std::min(result, ms);
+	}
+	return result;
+}
+
+template <typename Container>
+static void buildSmall(std::size_t count)
+{
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		Container container;
+		for (int j = 0; j < 6; ++j)
+			container.push_back(static_cast<int>(i) + j);
+		for (std::size_t j = 0; j < container.size(); ++j)
+			checksum += container[j];
+	}
+}
+
+int main()
+{
+	const std::size_t n = 1 << 20;
+	std::printf("2^20 containers of six ints\n");
+	std::printf("%-24s %7.1f ms\n", "SmallVector<int, 8>", best([&] { buildSmall<SmallVector<int, 8> >(n); }));
+	std::printf("%-24s %7.1f ms\n", "Vector<int>", best([&] { buildSmall<Vector<int> >(n); }));
+	std::printf("%-24s %7.1f ms\n", "std::vector<int>", best([&] { buildSmall<std::vector<int> >(n); }));
+	std::printf("checksum %zu\n", checksum);
+	return 0;
+}
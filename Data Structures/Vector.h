@@ -1,27 +1,149 @@
+#pragma once
 #include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
 
-template <typename T>
-class Vector {
+template <typename T, std::size_t N, typename Allocator>
+class SmallVector;
+
+/*
+The storage comes from Allocator, a standard allocator; the elements are constructed in it in place and destroyed
+through std::allocator_traits, so an allocator's own construct and destroy are honoured.
+The allocator is a (private, so empty ones take no room) base of the container.
+*/
+template <typename T, typename Allocator = std::allocator<T> >
+class Vector : private Allocator {
 private:
+	template <typename, std::size_t, typename>
+	friend class SmallVector; // shares the storage helpers below
+
+	using Traits = std::allocator_traits<Allocator>;
+	static_assert(std::is_same<typename Traits::pointer, T*>::value, "allocators with fancy pointers are not supported");
+
 	std::size_t mSize;
 	std::size_t mCapacity;
-	T* mArr; 
+	T* mArr; // raw storage, only [0, mSize) holds constructed elements
+
+	template <typename A, typename = void>
+	struct has_construct : std::false_type {};
+
+	template <typename A>
+	struct has_construct<A, decltype(std::declval<A&>().construct(std::declval<T*>(), std::declval<const T&>()), void())>
+		: std::true_type {};
+
+	template <typename A, typename = void>
+	struct has_destroy : std::false_type {};
+
+	template <typename A>
+	struct has_destroy<A, decltype(std::declval<A&>().destroy(std::declval<T*>()), void())> : std::true_type {};
+
+	/*
+	Whether elements are constructed and destroyed the plain way, by std::allocator or by allocator_traits for an
+	allocator without construct and destroy, so trivial element types may be copied with memcpy and not destroyed.
+	*/
+	static const bool PlainConstruct = std::is_same<Allocator, std::allocator<T> >::value
+		|| (!has_construct<Allocator>::value && !has_destroy<Allocator>::value);
+
+	/*
+	Allocates uninitialized storage for count elements from allocator. No allocation happens for count == 0.
+	*/
+	static T* allocate(Allocator& allocator, std::size_t count);
+
+	/*
+	Frees storage for count elements obtained from allocate().
+	*/
+	static void deallocate(Allocator& allocator, T* arr, std::size_t count);
+
+	/*
+	Destroys the elements in [first, last) through allocator.
+	*/
+	static void destroy(Allocator& allocator, T* first, T* last);
+
+	/*
+	Moves the count elements at from into the uninitialized storage at to and destroys the originals, through allocator.
+	Trivially copyable elements are copied with memcpy; others are moved if that cannot throw, copied otherwise,
+	so a throwing copy leaves the source intact.
+	*/
+	static void relocate(Allocator& allocator, T* from, std::size_t count, T* to);
+
+	/*
+	Moves the elements to new storage for new_capacity elements, constructing one more element at position mSize
+	from args first (args may refer to an element of the old storage).
+	*/
+	template <typename... Args>
+	void grow(std::size_t new_capacity, Args&&... args);
+
+	/*
+	Frees the storage and takes over the one of other, which is left empty. The elements must be gone and
+	other's storage must be one the allocator of *this can free.
+	*/
+	void steal(Vector& other);
+
+	/*
+	Copy assignment's part for allocators that propagate on it: takes over other's allocator, after freeing the
+	storage first if the current allocator is the only one that can free it. Does nothing for the others.
+	*/
+	void copy_allocator(const Vector& other, std::true_type);
+	void copy_allocator(const Vector& other, std::false_type);
+
+	/*
+	Move assignment's part that depends on the allocator: one that propagates is taken over from other, along with
+	the storage. Returns whether other's storage can be taken over, which is not the case for allocators that
+	neither propagate nor compare equal. The elements must be gone.
+	*/
+	bool move_allocator(Vector& other, std::true_type);
+	bool move_allocator(Vector& other, std::false_type);
+
+	Allocator& allocator();
+	const Allocator& allocator() const;
 public:
+	/*
+	The elements are contiguous, so plain pointers serve as iterators: Vector works with the std algorithms and,
+	in C++20, is a contiguous_range that std::span and the ranges algorithms accept directly.
+	*/
+	using value_type = T;
+	using allocator_type = Allocator;
+	using size_type = std::size_t;
+	using difference_type = std::ptrdiff_t;
+	using reference = T&;
+	using const_reference = const T&;
+	using pointer = T*;
+	using const_pointer = const T*;
+	using iterator = T*;
+	using const_iterator = const T*;
+	using reverse_iterator = std::reverse_iterator<iterator>;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
 	/*
 	Default constructor. Constructs an empty container
 	*/
 	Vector();
 
+	/*
+	Constructs an empty container using allocator.
+	*/
+	explicit Vector(const Allocator& allocator);
+
 	/*
 	Constructs the container with count copies of elements with default value.
 	*/
-	Vector(std::size_t count);
+	Vector(std::size_t count, const Allocator& allocator = Allocator());
 
 	/*
 	Copy constructor. Constructs the container with the copy of the contents of other.
+	The allocator is the one std::allocator_traits::select_on_container_copy_construction gives for other's.
 	*/
 	Vector(const Vector& vector);
 
+	/*
+	Move constructor. Takes over the storage and the allocator of other, which is left empty.
+	*/
+	Vector(Vector&& other) noexcept;
+
 	/*
 	Returns a reference to the element at specified location pos.
 	If user tries to access element out of bounds throw assertion.
@@ -32,14 +154,22 @@ public:
 	/*
 	Replaces the contents with a copy of the contents of other.
 	If capacity of target (*this) is smaller than number of elements in other, deallocate memory and allocate new one with others capacity.
+	The allocator is replaced as well if the allocator says it propagates on copy assignment.
 	*/
-	Vector<T>& operator=(const Vector<T>& other);
-	
+	Vector& operator=(const Vector& other);
+
+	/*
+	Move assignment. Releases the current contents and takes over the storage of other, which is left empty.
+	If the allocators neither propagate on move assignment nor compare equal, the storage cannot change hands and
+	the elements are moved one by one instead.
+	*/
+	Vector& operator=(Vector&& other) noexcept(Traits::propagate_on_container_move_assignment::value || Traits::is_always_equal::value);
+
 	/*
 	Checks if the contents of vectors are equal, that is, they have the same number of elements and
 	each element in current object compares equal with the element in other at the same position.
 	*/
-	bool operator==(const Vector<T>& other);
+	bool operator==(const Vector& other);
 
 	/*
 	Increase the capacity of the vector to a value that's greater or equal to new_capacity.
@@ -52,6 +182,13 @@ public:
 	Appends the given element value to the end of the container.
 	*/
 	void push_back(const T& elem);
+	void push_back(T&& elem);
+
+	/*
+	Appends a new element constructed in place from args. Returns a reference to it.
+	*/
+	template <typename... Args>
+	T& emplace_back(Args&&... args);
 
 	/*
 	Resizes the container to contain count elements.
@@ -78,6 +215,34 @@ public:
 	T& back();
 	const T& back() const;
 
+	/*
+	Returns a pointer to the underlying storage. [data(), data() + size()) is always a valid range, even when empty.
+	*/
+	T* data();
+	const T* data() const;
+
+	/*
+	Returns an iterator to the first element, or end() if the container is empty.
+	*/
+	iterator begin();
+	const_iterator begin() const;
+	const_iterator cbegin() const;
+
+	/*
+	Returns an iterator past the last element.
+	*/
+	iterator end();
+	const_iterator end() const;
+	const_iterator cend() const;
+
+	/*
+	Reverse iterators, from the last element to the first.
+	*/
+	reverse_iterator rbegin();
+	const_reverse_iterator rbegin() const;
+	reverse_iterator rend();
+	const_reverse_iterator rend() const;
+
 	/*
 	Checks if the container has no elements.
 	*/
@@ -93,6 +258,11 @@ public:
 	*/
 	std::size_t capacity() const;
 
+	/*
+	Returns a copy of the allocator.
+	*/
+	Allocator get_allocator() const;
+
 	/*
 	Destructs the vector. The destructors of the elements are called and the used storage is deallocated.
 	*/
@@ -103,77 +273,315 @@ public:
 
 #include <cassert>
 
-template <typename T>
-Vector<T>::Vector() : mSize(0), mCapacity(0), mArr(nullptr)
+template <typename T, typename Allocator>
+T* Vector<T, Allocator>::allocate(Allocator& allocator, std::size_t count)
+{
+	if (count == 0)
+		return nullptr;
+	if (count > static_cast<std::size_t>(-1) / sizeof(T))
+		throw std::bad_array_new_length();
+
+	return Traits::allocate(allocator, count);
+}
+
+template <typename T, typename Allocator>
+void Vector<T, Allocator>::deallocate(Allocator& allocator, T* arr, std::size_t count)
 {
+	if (arr)
+		Traits::deallocate(allocator, arr, count);
+}
 
+template <typename T, typename Allocator>
+void Vector<T, Allocator>::destroy(Allocator& allocator, T* first, T* last)
+{
+	if (!std::is_trivially_destructible<T>::value || !PlainConstruct)
+		for (; first != last; ++first)
+			Traits::destroy(allocator, first);
 }
 
 /*
-Constructs the container with count copies of elements with default value.
+Moves the count elements at from into the uninitialized storage at to and destroys the originals.
+*/
+template <typename T, typename Allocator>
+void Vector<T, Allocator>::relocate(Allocator& allocator, T* from, std::size_t count, T* to)
+{
+	if (std::is_trivially_copyable<T>::value && PlainConstruct)
+	{
+		if (count)
+			std::memcpy(static_cast<void*>(to), static_cast<const void*>(from), count * sizeof(T));
+		return;
+	}
+
+	std::size_t i = 0;
+	try
+	{
+		for (; i < count; ++i)
+			Traits::construct(allocator, to + i, std::move_if_noexcept(from[i]));
+	}
+	catch (...)
+	{
+		destroy(allocator, to, to + i);
+		throw;
+	}
+	destroy(allocator, from, from + count);
+}
+
+template <typename T, typename Allocator>
+template <typename... Args>
+void Vector<T, Allocator>::grow(std::size_t new_capacity, Args&&... args)
+{
+	T* newArr = allocate(allocator(), new_capacity);
+	try
+	{
+		Traits::construct(allocator(), newArr + mSize, std::forward<Args>(args)...);
+	}
+	catch (...)
+	{
+		deallocate(allocator(), newArr, new_capacity);
+		throw;
+	}
+
+	try
+	{
+		relocate(allocator(), mArr, mSize, newArr);
+	}
+	catch (...)
+	{
+		Traits::destroy(allocator(), newArr + mSize);
+		deallocate(allocator(), newArr, new_capacity);
+		throw;
+	}
+
+	deallocate(allocator(), mArr, mCapacity);
+	mArr = newArr;
+	mCapacity = new_capacity;
+	++mSize;
+}
+
+template <typename T, typename Allocator>
+void Vector<T, Allocator>::steal(Vector& other)
+{
+	deallocate(allocator(), mArr, mCapacity);
+
+	mSize = other.mSize;
+	mCapacity = other.mCapacity;
+	mArr = other.mArr;
+	other.mSize = other.mCapacity = 0;
+	other.mArr = nullptr;
+}
+
+template <typename T, typename Allocator>
+void Vector<T, Allocator>::copy_allocator(const Vector& other, std::true_type)
+{
+	if (!Traits::is_always_equal::value && allocator() != other.allocator())
+	{
+		// the storage belongs to the allocator being replaced
+		destroy(allocator(), mArr, mArr + mSize);
+		deallocate(allocator(), mArr, mCapacity);
+		mSize = mCapacity = 0;
+		mArr = nullptr;
+	}
+	allocator() = other.allocator();
+}
+
+template <typename T, typename Allocator>
+void Vector<T, Allocator>::copy_allocator(const Vector&, std::false_type)
+{
+
+}
+
+template <typename T, typename Allocator>
+bool Vector<T, Allocator>::move_allocator(Vector& other, std::true_type)
+{
+	deallocate(allocator(), mArr, mCapacity);
+	mCapacity = 0;
+	mArr = nullptr;
+	allocator() = std::move(other.allocator());
+	return true;
+}
+
+template <typename T, typename Allocator>
+bool Vector<T, Allocator>::move_allocator(Vector& other, std::false_type)
+{
+	return Traits::is_always_equal::value || allocator() == other.allocator();
+}
+
+template <typename T, typename Allocator>
+Allocator& Vector<T, Allocator>::allocator()
+{
+	return *this;
+}
+
+template <typename T, typename Allocator>
+const Allocator& Vector<T, Allocator>::allocator() const
+{
+	return *this;
+}
+
+template <typename T, typename Allocator>
+Vector<T, Allocator>::Vector() : Allocator(), mSize(0), mCapacity(0), mArr(nullptr)
+{
+
+}
+
+/*
+Constructs an empty container using allocator.
 */
-template <typename T>
-Vector<T>::Vector(std::size_t count) : mSize(count), mCapacity(count), mArr(new T[count]{})
+template <typename T, typename Allocator>
+Vector<T, Allocator>::Vector(const Allocator& allocator) : Allocator(allocator), mSize(0), mCapacity(0), mArr(nullptr)
 {
 
 }
 
+/*
+Constructs the container with count copies of elements with default value.
+*/
+template <typename T, typename Allocator>
+Vector<T, Allocator>::Vector(std::size_t count, const Allocator& allocator)
+	: Allocator(allocator), mSize(0), mCapacity(count), mArr(allocate(this->allocator(), count))
+{
+	try
+	{
+		for (; mSize < count; ++mSize)
+			Traits::construct(this->allocator(), mArr + mSize);
+	}
+	catch (...)
+	{
+		destroy(this->allocator(), mArr, mArr + mSize);
+		deallocate(this->allocator(), mArr, mCapacity);
+		throw;
+	}
+}
+
 /*
 Copy constructor. Constructs the container with the copy of the contents of other.
+The allocator is the one std::allocator_traits::select_on_container_copy_construction gives for other's.
 */
+template <typename T, typename Allocator>
+Vector<T, Allocator>::Vector(const Vector<T, Allocator>& vector)
+	: Allocator(Traits::select_on_container_copy_construction(vector.allocator())), mSize(0), mCapacity(vector.mCapacity),
+	mArr(allocate(allocator(), vector.mCapacity))
+{
+	if (std::is_trivially_copyable<T>::value && PlainConstruct)
+	{
+		if (vector.mSize)
+			std::memcpy(static_cast<void*>(mArr), static_cast<const void*>(vector.mArr), vector.mSize * sizeof(T));
+		mSize = vector.mSize;
+		return;
+	}
+
+	try
+	{
+		for (; mSize < vector.mSize; ++mSize)
+			Traits::construct(allocator(), mArr + mSize, vector.mArr[mSize]);
+	}
+	catch (...)
+	{
+		destroy(allocator(), mArr, mArr + mSize);
+		deallocate(allocator(), mArr, mCapacity);
+		throw;
+	}
+}
 
-template <typename T>
-Vector<T>::Vector(const Vector<T>& vector) : mSize(vector.mSize), mCapacity(vector.mCapacity), mArr(new T[vector.mCapacity])
+/*
+Move constructor. Takes over the storage and the allocator of other, which is left empty.
+*/
+template <typename T, typename Allocator>
+Vector<T, Allocator>::Vector(Vector<T, Allocator>&& other) noexcept
+	: Allocator(std::move(other.allocator())), mSize(other.mSize), mCapacity(other.mCapacity), mArr(other.mArr)
 {
-	for (std::size_t i = 0; i < mSize; ++i)
-		mArr[i] = vector.mArr[i];
+	other.mSize = other.mCapacity = 0;
+	other.mArr = nullptr;
 }
 
 /*
 Returns a reference to the element at specified location pos.
 If user tries to access element out of bounds throw assertion.
 */
-template <typename T>
-T& Vector<T>::operator[](std::size_t pos)
+template <typename T, typename Allocator>
+T& Vector<T, Allocator>::operator[](std::size_t pos)
 {
-	assert(pos >= 0 && pos < mSize);
+	assert(pos < mSize);
 	return mArr[pos];
 }
 
-template <typename T>
-const T& Vector<T>::operator[](std::size_t pos) const
+template <typename T, typename Allocator>
+const T& Vector<T, Allocator>::operator[](std::size_t pos) const
 {
-	assert(pos >= 0 && pos < mSize);
+	assert(pos < mSize);
 	return mArr[pos];
 }
 
 /*
 Replaces the contents with a copy of the contents of other.
 If capacity of target (*this) is smaller than number of elements in other, deallocate memory and allocate new one with others capacity.
+The allocator is replaced as well if the allocator says it propagates on copy assignment.
 */
-template <typename T>
-Vector<T>& Vector<T>::operator=(const Vector<T>& other)
+template <typename T, typename Allocator>
+Vector<T, Allocator>& Vector<T, Allocator>::operator=(const Vector<T, Allocator>& other)
 {
 	if (this == &other)
 		return *this;
 
-	if (mCapacity < other.mCapacity)
-		reserve(other.mCapacity);
+	copy_allocator(other, typename Traits::propagate_on_container_copy_assignment());
+
+	if (mCapacity < other.mSize)
+	{
+		Vector copy(allocator());
+		copy.reserve(other.mCapacity);
+		for (; copy.mSize < other.mSize; ++copy.mSize)
+			Traits::construct(copy.allocator(), copy.mArr + copy.mSize, other.mArr[copy.mSize]);
+
+		clear();
+		steal(copy);
+		return *this;
+	}
 
-	for (std::size_t i = 0; i < other.mSize; ++i)
+	std::size_t common = mSize < other.mSize ? mSize : other.mSize;
+	for (std::size_t i = 0; i < common; ++i)
 		mArr[i] = other.mArr[i];
 
+	for (; mSize < other.mSize; ++mSize)
+		Traits::construct(allocator(), mArr + mSize, other.mArr[mSize]);
+
+	destroy(allocator(), mArr + other.mSize, mArr + mSize);
 	mSize = other.mSize;
 
 	return *this;
 }
 
+/*
+Move assignment. Releases the current contents and takes over the storage of other, which is left empty.
+If the allocators neither propagate on move assignment nor compare equal, the storage cannot change hands and
+the elements are moved one by one instead.
+*/
+template <typename T, typename Allocator>
+Vector<T, Allocator>& Vector<T, Allocator>::operator=(Vector<T, Allocator>&& other)
+	noexcept(Traits::propagate_on_container_move_assignment::value || Traits::is_always_equal::value)
+{
+	if (this == &other)
+		return *this;
+
+	clear();
+	if (!move_allocator(other, typename Traits::propagate_on_container_move_assignment()))
+	{
+		reserve(other.mSize);
+		for (; mSize < other.mSize; ++mSize)
+			Traits::construct(allocator(), mArr + mSize, std::move(other.mArr[mSize]));
+		other.clear();
+		return *this;
+	}
+
+	steal(other);
+	return *this;
+}
+
 /*
 Checks if the contents of vectors are equal, that is, they have the same number of elements and
 each element in current object compares equal with the element in other at the same position.
 */
-template <typename T>
-bool Vector<T>::operator==(const Vector<T>& other)
+template <typename T, typename Allocator>
+bool Vector<T, Allocator>::operator==(const Vector<T, Allocator>& other)
 {
 	if (this == &other)
 		return true;
@@ -192,39 +600,61 @@ Increase the capacity of the vector to a value that's greater or equal to new_ca
 If new_capacity is greater than the current capacity(), new storage is allocated, otherwise the method does nothing.
 reserve() does not change the size of the vector.
 */
-template <typename T>
-void Vector<T>::reserve(std::size_t new_capacity)
+template <typename T, typename Allocator>
+void Vector<T, Allocator>::reserve(std::size_t new_capacity)
 {
 	if (new_capacity <= mCapacity)
 		return;
 
-	T* newArr = new T[new_capacity]{};
-	mCapacity = new_capacity;
-
-	for (std::size_t i = 0; i < mSize; ++i)
-		newArr[i] = mArr[i];
+	T* newArr = allocate(allocator(), new_capacity);
+	try
+	{
+		relocate(allocator(), mArr, mSize, newArr);
+	}
+	catch (...)
+	{
+		deallocate(allocator(), newArr, new_capacity);
+		throw;
+	}
 
-	delete[] mArr;
+	deallocate(allocator(), mArr, mCapacity);
 	mArr = newArr;
+	mCapacity = new_capacity;
 }
 
 /*
 Appends the given element value to the end of the container.
 */
-template <typename T>
-void Vector<T>::push_back(const T& elem)
+template <typename T, typename Allocator>
+void Vector<T, Allocator>::push_back(const T& elem)
+{
+	emplace_back(elem);
+}
+
+template <typename T, typename Allocator>
+void Vector<T, Allocator>::push_back(T&& elem)
+{
+	emplace_back(std::move(elem));
+}
+
+/*
+Appends a new element constructed in place from args. Returns a reference to it.
+When the storage is full, the new element is constructed in the new storage before the old elements are moved,
+so args may refer to an element of the container itself.
+*/
+template <typename T, typename Allocator>
+template <typename... Args>
+T& Vector<T, Allocator>::emplace_back(Args&&... args)
 {
 	if (mSize < mCapacity)
 	{
-		mArr[mSize++] = elem;
-		return;
+		// counted only once constructed, a throwing constructor leaves the size as it was
+		Traits::construct(allocator(), mArr + mSize, std::forward<Args>(args)...);
+		++mSize;
 	}
-
-	if (mCapacity == 0)
-		reserve(1);
 	else
-		reserve(mCapacity * 2);
-	mArr[mSize++] = elem;
+		grow(mCapacity == 0 ? 1 : mCapacity * 2, std::forward<Args>(args)...);
+	return mArr[mSize - 1];
 }
 
 /*
@@ -232,14 +662,16 @@ Resizes the container to contain count elements.
 If the current size is greater than count, the container is reduced to its first count elements.
 If the current size is less than count, additional default-inserted elements are appended.
 */
-template <typename T>
-void Vector<T>::resize(std::size_t count)
+template <typename T, typename Allocator>
+void Vector<T, Allocator>::resize(std::size_t count)
 {
 	if (count > mCapacity)
 		reserve(count);
 
-	for (std::size_t i = mSize; i < count; ++i)
-		mArr[i] = T();
+	if (count < mSize)
+		destroy(allocator(), mArr + count, mArr + mSize);
+	for (; mSize < count; ++mSize)
+		Traits::construct(allocator(), mArr + mSize);
 	mSize = count;
 }
 
@@ -247,19 +679,20 @@ void Vector<T>::resize(std::size_t count)
 Removes the last element of the container.
 If user tries to call pop_back on an empty container throw assertion.
 */
-template <typename T>
-void Vector<T>::pop_back()
+template <typename T, typename Allocator>
+void Vector<T, Allocator>::pop_back()
 {
 	assert(mSize);
-	--mSize;
+	Traits::destroy(allocator(), mArr + --mSize);
 }
 
 /*
 Erases all elements from the container. After this call, size() returns zero.
 */
-template <typename T>
-void Vector<T>::clear()
+template <typename T, typename Allocator>
+void Vector<T, Allocator>::clear()
 {
+	destroy(allocator(), mArr, mArr + mSize);
 	mSize = 0;
 }
 
@@ -267,25 +700,109 @@ void Vector<T>::clear()
 Returns reference to the last element in the container.
 If user tries to call back on an empty container throw assertion.
 */
-template <typename T>
-T& Vector<T>::back()
+template <typename T, typename Allocator>
+T& Vector<T, Allocator>::back()
 {
 	assert(mSize);
 	return mArr[mSize - 1];
 }
 
-template <typename T>
-const T& Vector<T>::back() const
+template <typename T, typename Allocator>
+const T& Vector<T, Allocator>::back() const
 {
 	assert(mSize);
 	return mArr[mSize - 1];
 }
 
+/*
+Returns a pointer to the underlying storage. [data(), data() + size()) is always a valid range, even when empty.
+*/
+template <typename T, typename Allocator>
+T* Vector<T, Allocator>::data()
+{
+	return mArr;
+}
+
+template <typename T, typename Allocator>
+const T* Vector<T, Allocator>::data() const
+{
+	return mArr;
+}
+
+/*
+Returns an iterator to the first element, or end() if the container is empty.
+*/
+template <typename T, typename Allocator>
+typename Vector<T, Allocator>::iterator Vector<T, Allocator>::begin()
+{
+	return mArr;
+}
+
+template <typename T, typename Allocator>
+typename Vector<T, Allocator>::const_iterator Vector<T, Allocator>::begin() const
+{
+	return mArr;
+}
+
+template <typename T, typename Allocator>
+typename Vector<T, Allocator>::const_iterator Vector<T, Allocator>::cbegin() const
+{
+	return mArr;
+}
+
+/*
+Returns an iterator past the last element.
+*/
+template <typename T, typename Allocator>
+typename Vector<T, Allocator>::iterator Vector<T, Allocator>::end()
+{
+	return mArr + mSize;
+}
+
+template <typename T, typename Allocator>
+typename Vector<T, Allocator>::const_iterator Vector<T, Allocator>::end() const
+{
+	return mArr + mSize;
+}
+
+template <typename T, typename Allocator>
+typename Vector<T, Allocator>::const_iterator Vector<T, Allocator>::cend() const
+{
+	return mArr + mSize;
+}
+
+/*
+Reverse iterators, from the last element to the first.
+*/
+template <typename T, typename Allocator>
+typename Vector<T, Allocator>::reverse_iterator Vector<T, Allocator>::rbegin()
+{
+	return reverse_iterator(end());
+}
+
+template <typename T, typename Allocator>
+typename Vector<T, Allocator>::const_reverse_iterator Vector<T, Allocator>::rbegin() const
+{
+	return const_reverse_iterator(end());
+}
+
+template <typename T, typename Allocator>
+typename Vector<T, Allocator>::reverse_iterator Vector<T, Allocator>::rend()
+{
+	return reverse_iterator(begin());
+}
+
+template <typename T, typename Allocator>
+typename Vector<T, Allocator>::const_reverse_iterator Vector<T, Allocator>::rend() const
+{
+	return const_reverse_iterator(begin());
+}
+
 /*
 Checks if the container has no elements.
 */
-template <typename T>
-bool Vector<T>::empty() const
+template <typename T, typename Allocator>
+bool Vector<T, Allocator>::empty() const
 {
 	return mSize == 0;
 }
@@ -293,8 +810,8 @@ bool Vector<T>::empty() const
 /*
 Returns the number of elements in the container.
 */
-template <typename T>
-std::size_t Vector<T>::size() const
+template <typename T, typename Allocator>
+std::size_t Vector<T, Allocator>::size() const
 {
 	return mSize;
 }
@@ -302,17 +819,35 @@ std::size_t Vector<T>::size() const
 /*
 Returns the number of elements that the container has currently allocated space for.
 */
-template <typename T>
-std::size_t Vector<T>::capacity() const
+template <typename T, typename Allocator>
+std::size_t Vector<T, Allocator>::capacity() const
 {
 	return mCapacity;
 }
 
+/*
+Returns a copy of the allocator.
+*/
+template <typename T, typename Allocator>
+Allocator Vector<T, Allocator>::get_allocator() const
+{
+	return allocator();
+}
+
 /*
 Destructs the vector. The destructors of the elements are called and the used storage is deallocated.
 */
-template <typename T>
-Vector<T>::~Vector()
+template <typename T, typename Allocator>
+Vector<T, Allocator>::~Vector()
 {
-	delete[] mArr;
+	destroy(allocator(), mArr, mArr + mSize);
+	deallocate(allocator(), mArr, mCapacity);
 }
+
+#if __cplusplus >= 202002L && __has_include(<ranges>)
+#include <ranges>
+#include <span>
+
+static_assert(std::ranges::contiguous_range<Vector<int> > && std::ranges::sized_range<Vector<int> >);
+static_assert(std::is_constructible_v<std::span<int>, Vector<int>&>);
+#endif
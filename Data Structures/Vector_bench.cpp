@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "Vector.h"
+
+/*
+Benchmark of appending to an empty Vector, against std::vector: 2^20 strings of 48 characters, 2^23 ints and
+2^18 copies of a Vector<int> of 16 elements. Each case runs three times and the best time is printed.
+Build and run:
+	g++ -std=c++17 -O2 Vector_bench.cpp -o Vector_bench && ./Vector_bench
+The program only uses the default and count constructors, push_back, size and operator[], which every revision of
+Vector has, so it can measure an older one too: copy it next to that revision's Vector.h (from git show) and
+build it there.
+*/
+
+using Clock = std::chrono::steady_clock;
+
+static std::size_t checksum = 0; // printed, so the work cannot be optimized away
+
+/*
+Runs f three times and returns the best time in milliseconds.
+*/
+template <typename F>
+static double best(F f)
+{
+	double result = 0;
+	for (int run = 0; run < 3; ++run)
+	{
+		Clock::time_point start = Clock::now();
+		f();
+		double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		result = run == 0 ? ms : std::min(result, ms);
+	}
+	return result;
+}
+
+template <typename Container, typename T>
+static void append(std::size_t count, const T& value)
+{
+	Container container;
+	for (std::size_t i = 0; i < count; ++i)
+		container.push_back(value);
+	checksum += container.size();
+}
+
+static void appendInts(std::size_t count)
+{
+	Vector<int> vector;
+	for (std::size_t i = 0; i < count; ++i)
+		vector.push_back(static_cast<int>(i));
+	checksum += vector.size() + vector[count / 2];
+}
+
+static void appendStdInts(std::size_t count)
+{
+	std::vector<int> vector;
+	for (std::size_t i = 0; i < count; ++i)
+		vector.push_back(static_cast<int>(i));
+	checksum += vector.size() + vector[count / 2];
+}
+
+int main()
+{
+	const std::size_t n = 1 << 20;
+	const std::string text(48, 'x');
+	const Vector<int> inner(16);
+	const std::vector<int> stdInner(16);
+
+	std::printf("%-36s %10s %12s\n", "appends to an empty container", "Vector", "std::vector");
+	std::printf("%-36s %7.1f ms %9.1f ms\n", "2^20 strings of 48 chars",
+		best([&] { append<Vector<std::string> >(n, text); }), best([&] { append<std::vector<std::string> >(n, text); }));
+	std::printf("%-36s %7.1f ms %9.1f ms\n", "2^23 ints",
+		best([&] { appendInts(8 * n); }), best([&] { appendStdInts(8 * n); }));
+	std::printf("%-36s %7.1f ms %9.1f ms\n", "2^18 Vector<int>s of 16 elements",
+		best([&] { append<Vector<Vector<int> > >(n / 4, inner); }),
+		best([&] { append<std::vector<std::vector<int> > >(n / 4, stdInner); }));
+	std::printf("checksum %zu\n", checksum);
+	return 0;
+}
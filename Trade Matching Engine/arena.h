@@ -0,0 +1,234 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <ostream>
+
+#include <sys/mman.h>
+
+/*
+One large mapping the book carves its map nodes, deque blocks and order storage from, instead of many small heap
+allocations spread over the address space. The mapping can be backed by explicit 2MB huge pages (MAP_HUGETLB),
+by transparent huge pages (madvise) or by normal pages; explicit falls back to transparent when the system has no
+huge pages reserved. Freed blocks go to per-size free lists (16 byte classes up to MaxBlock) and are reused first,
+so levels that keep emptying and refilling do not grow the arena. Requests the arena cannot serve (larger than
+MaxBlock or after it is exhausted) fall back to operator new and are counted.
+Not thread safe: only the matching thread may allocate from it.
+*/
+class Arena {
+public:
+	enum class Pages { Normal, Transparent, Explicit };
+
+	struct Stats {
+		std::size_t reserved;   // bytes mapped
+		std::size_t carved;     // bytes handed out from the mapping at least once (high-water mark)
+		std::size_t inUse;      // bytes currently allocated from the mapping
+		std::size_t fallbacks;  // allocations served by operator new
+		std::size_t live;       // bytes requested and not yet freed, fallbacks included, before size class rounding
+		Pages pages;
+	};
+private:
+	static const std::size_t Granularity = 16;
+	static const std::size_t MaxBlock = 4096;
+	static const std::size_t HugePage = std::size_t(2) << 20;
+
+	struct FreeBlock {
+		FreeBlock* mNext;
+	};
+
+	char* mBegin;
+	char* mCur;
+	char* mEnd;
+	FreeBlock* mFree[MaxBlock / Granularity + 1];
+	std::size_t mInUse;
+	std::size_t mFallbacks;
+	std::size_t mLive;
+	Pages mPages;
+
+	static std::size_t sizeClass(std::size_t bytes)
+	{
+		return (bytes + Granularity - 1) / Granularity;
+	}
+public:
+	Arena() : mBegin(nullptr), mCur(nullptr), mEnd(nullptr), mFree(), mInUse(0), mFallbacks(0), mLive(0), mPages(Pages::Normal)
+	{
+
+	}
+
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	/*
+	Maps bytes (rounded up to a huge page) with the requested page kind, falling back to smaller pages.
+	Must be called before the first allocation; without it everything falls back to operator new.
+	Returns false if nothing could be mapped.
+	*/
+	bool reserve(std::size_t bytes, Pages pages)
+	{
+		if (mBegin || bytes == 0)
+			return false;
+
+		bytes = (bytes + HugePage - 1) / HugePage * HugePage;
+		void* addr = MAP_FAILED;
+
+		if (pages == Pages::Explicit)
+		{
+			addr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+			if (addr == MAP_FAILED)
+				pages = Pages::Transparent;
+		}
+
+		if (addr == MAP_FAILED)
+		{
+			addr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+			if (addr == MAP_FAILED)
+				return false;
+
+			if (pages == Pages::Transparent && madvise(addr, bytes, MADV_HUGEPAGE) != 0)
+				pages = Pages::Normal;
+		}
+
+		mBegin = mCur = static_cast<char*>(addr);
+		mEnd = mBegin + bytes;
+		mPages = pages;
+		return true;
+	}
+
+	/*
+	Start and length of the mapping, e.g. to bind it to a NUMA node.
+	*/
+	void* data() const
+	{
+		return mBegin;
+	}
+
+	std::size_t capacity() const
+	{
+		return static_cast<std::size_t>(mEnd - mBegin);
+	}
+
+	void* allocate(std::size_t bytes)
+	{
+		mLive += bytes;
+		std::size_t cls = sizeClass(bytes);
+		if (cls * Granularity <= MaxBlock)
+		{
+			if (FreeBlock* block = mFree[cls])
+			{
+				mFree[cls] = block->mNext;
+				mInUse += cls * Granularity;
+				return block;
+			}
+
+			if (static_cast<std::size_t>(mEnd - mCur) >= cls * Granularity)
+			{
+				void* block = mCur;
+				mCur += cls * Granularity;
+				mInUse += cls * Granularity;
+				return block;
+			}
+		}
+
+		++mFallbacks;
+		return ::operator new(bytes);
+	}
+
+	void deallocate(void* ptr, std::size_t bytes)
+	{
+		mLive -= bytes;
+		char* p = static_cast<char*>(ptr);
+		if (p < mBegin || p >= mEnd)
+		{
+			::operator delete(ptr);
+			return;
+		}
+
+		std::size_t cls = sizeClass(bytes);
+		FreeBlock* block = static_cast<FreeBlock*>(ptr);
+		block->mNext = mFree[cls];
+		mFree[cls] = block;
+		mInUse -= cls * Granularity;
+	}
+
+	Stats stats() const
+	{
+		return { capacity(), static_cast<std::size_t>(mCur - mBegin), mInUse, mFallbacks, mLive, mPages };
+	}
+
+	void print(std::ostream& output) const
+	{
+		const char* pages[] = { "normal", "transparent huge", "explicit huge" };
+		const double mb = 1 << 20;
+		Stats st = stats();
+		output << "arena: " << st.reserved / mb << " MB reserved (" << pages[static_cast<int>(st.pages)] << " pages), "
+			<< st.carved / mb << " MB carved, " << st.inUse / mb << " MB in use ("
+			<< (st.reserved ? 100.0 * st.inUse / st.reserved : 0.0) << "%), " << st.fallbacks << " heap fallbacks\n";
+	}
+
+	~Arena()
+	{
+		if (mBegin)
+			munmap(mBegin, capacity());
+	}
+};
+
+/*
+The arena the order book lives in. There is one book per process, owned by the matching thread.
+*/
+inline Arena& bookArena()
+{
+	static Arena arena;
+	return arena;
+}
+
+/*
+Standard allocator over bookArena(), for the book's containers. Keeps the bytes live per element type, so the
+footprint of the book can be split into order storage and the containers' own bookkeeping.
+*/
+template <typename T>
+struct ArenaAllocator {
+	using value_type = T;
+	using is_always_equal = std::true_type;
+
+	ArenaAllocator() = default;
+
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>&)
+	{
+
+	}
+
+	static std::size_t& liveBytes()
+	{
+		static std::size_t bytes = 0;
+		return bytes;
+	}
+
+	T* allocate(std::size_t count)
+	{
+		if (count > std::numeric_limits<std::size_t>::max() / sizeof(T))
+			throw std::bad_alloc();
+		liveBytes() += count * sizeof(T);
+		return static_cast<T*>(bookArena().allocate(count * sizeof(T)));
+	}
+
+	void deallocate(T* ptr, std::size_t count)
+	{
+		liveBytes() -= count * sizeof(T);
+		bookArena().deallocate(ptr, count * sizeof(T));
+	}
+
+	template <typename U>
+	bool operator==(const ArenaAllocator<U>&) const
+	{
+		return true;
+	}
+
+	template <typename U>
+	bool operator!=(const ArenaAllocator<U>&) const
+	{
+		return false;
+	}
+};
@@ -0,0 +1,263 @@
+#pragma once
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define ENGINE_HAS_COROUTINES 1
+
+#include <cerrno>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+/*
+Completion based file I/O for one coroutine. read() and write() start an operation right away and return a Pending
+the coroutine co_awaits later, so it can keep a read and a write in flight while it works on the previous buffer.
+The operations run as blocking syscalls on a small pool of worker threads; finished ones are handed back through a
+completion queue that run() drains on the calling thread, and the coroutine is always resumed there, never on a
+worker. The model is the one of io_uring (submit, then reap completions), without needing the library.
+At most one operation per file descriptor and direction should be in flight, workers may complete them out of order.
+*/
+class AsyncIo {
+private:
+	struct Operation {
+		int mFd;
+		char* mData;
+		std::size_t mSize;
+		bool mWrite;
+		long mResult = 0;   // bytes transferred, -1 on error
+		int mError = 0;
+		bool mDone = false;  // only touched by the thread in run()
+		std::coroutine_handle<> mWaiter = nullptr;
+	};
+
+	std::mutex mMutex;
+	std::condition_variable mWork;
+	std::condition_variable mCompletion;
+	std::deque<Operation*> mSubmitted;
+	std::deque<Operation*> mCompleted;
+	std::vector<std::thread> mWorkers;
+	bool mStop = false;
+
+	static void perform(Operation& op)
+	{
+		if (!op.mWrite)
+		{
+			do
+				op.mResult = ::read(op.mFd, op.mData, op.mSize);
+			while (op.mResult == -1 && errno == EINTR);
+		}
+		else
+		{
+			// a write completes only once the whole buffer is out
+			std::size_t written = 0;
+			while (written < op.mSize)
+			{
+				long n = ::write(op.mFd, op.mData + written, op.mSize - written);
+				if (n == -1 && errno == EINTR)
+					continue;
+				if (n <= 0)
+					break;
+				written += static_cast<std::size_t>(n);
+			}
+			op.mResult = written == op.mSize ? static_cast<long>(written) : -1;
+		}
+		op.mError = op.mResult == -1 ? errno : 0;
+	}
+
+	void work()
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		for (;;)
+		{
+			mWork.wait(lock, [this]() { return mStop || !mSubmitted.empty(); });
+			if (mSubmitted.empty())
+				return;
+
+			Operation* op = mSubmitted.front();
+			mSubmitted.pop_front();
+			lock.unlock();
+			perform(*op);
+			lock.lock();
+			mCompleted.push_back(op);
+			mCompletion.notify_one();
+		}
+	}
+
+	void submit(Operation* op)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mSubmitted.push_back(op);
+		}
+		mWork.notify_one();
+	}
+public:
+	/*
+	An operation in flight. co_await gives its result: bytes transferred, 0 at end of input, -1 with errno set.
+	Must be awaited before it is destroyed or reassigned.
+	*/
+	class Pending {
+	private:
+		std::unique_ptr<Operation> mOp;
+	public:
+		Pending() = default;
+
+		explicit Pending(std::unique_ptr<Operation> op) : mOp(std::move(op))
+		{
+
+		}
+
+		bool active() const
+		{
+			return mOp != nullptr;
+		}
+
+		bool await_ready() const
+		{
+			return mOp->mDone;
+		}
+
+		void await_suspend(std::coroutine_handle<> waiter)
+		{
+			mOp->mWaiter = waiter;
+		}
+
+		long await_resume()
+		{
+			long result = mOp->mResult;
+			errno = mOp->mError;
+			mOp.reset();
+			return result;
+		}
+	};
+
+	/*
+	The coroutine driven by run(). It starts suspended and its co_return value is what run() returns.
+	*/
+	class Task {
+	public:
+		struct promise_type {
+			int mResult = 0;
+
+			Task get_return_object()
+			{
+				return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+			}
+
+			std::suspend_always initial_suspend() noexcept
+			{
+				return {};
+			}
+
+			std::suspend_always final_suspend() noexcept
+			{
+				return {};
+			}
+
+			void return_value(int result)
+			{
+				mResult = result;
+			}
+
+			void unhandled_exception()
+			{
+				std::terminate();
+			}
+		};
+	private:
+		std::coroutine_handle<promise_type> mHandle;
+
+		friend class AsyncIo;
+	public:
+		explicit Task(std::coroutine_handle<promise_type> handle) : mHandle(handle)
+		{
+
+		}
+
+		Task(Task&& other) noexcept : mHandle(std::exchange(other.mHandle, nullptr))
+		{
+
+		}
+
+		Task(const Task&) = delete;
+		Task& operator=(const Task&) = delete;
+
+		~Task()
+		{
+			if (mHandle)
+				mHandle.destroy();
+		}
+	};
+
+	explicit AsyncIo(unsigned threads = 2)
+	{
+		for (unsigned i = 0; i < threads; ++i)
+			mWorkers.emplace_back(&AsyncIo::work, this);
+	}
+
+	AsyncIo(const AsyncIo&) = delete;
+	AsyncIo& operator=(const AsyncIo&) = delete;
+
+	/*
+	Starts reading up to size bytes from fd into data.
+	*/
+	Pending read(int fd, char* data, std::size_t size)
+	{
+		std::unique_ptr<Operation> op(new Operation{ fd, data, size, false });
+		submit(op.get());
+		return Pending(std::move(op));
+	}
+
+	/*
+	Starts writing all size bytes at data to fd. The buffer must stay untouched until the write is awaited.
+	*/
+	Pending write(int fd, const char* data, std::size_t size)
+	{
+		std::unique_ptr<Operation> op(new Operation{ fd, const_cast<char*>(data), size, true });
+		submit(op.get());
+		return Pending(std::move(op));
+	}
+
+	/*
+	Runs task on the calling thread until it finishes, resuming it whenever an operation it waits for completes.
+	*/
+	int run(Task& task)
+	{
+		task.mHandle.resume();
+		while (!task.mHandle.done())
+		{
+			Operation* op;
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				mCompletion.wait(lock, [this]() { return !mCompleted.empty(); });
+				op = mCompleted.front();
+				mCompleted.pop_front();
+			}
+
+			op->mDone = true;
+			if (std::coroutine_handle<> waiter = std::exchange(op->mWaiter, nullptr))
+				waiter.resume();
+		}
+		return task.mHandle.promise().mResult;
+	}
+
+	~AsyncIo()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mStop = true;
+		}
+		mWork.notify_all();
+		for (std::thread& worker : mWorkers)
+			worker.join();
+	}
+};
+
+#endif
@@ -0,0 +1,703 @@
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "arena.h"
+
+/*
+The policies the matching engine of tech_assignment.cpp is a template over, so every combination is its own build
+with no virtual calls in the matching loop:
+IdPolicy   - how trader identifiers are kept in orders (TraderTable interns them to ints, StringIds keeps strings);
+BookPolicy - how price levels are stored, a struct with a nested template Type<Order> (MapBook, ArrayBook);
+Reporter   - what an execution is turned into (TextReporter renders the assignment's lines, BinaryReporter records).
+*/
+
+/*
+Maps trader identifiers to small dense integers, so the matching loop compares ints instead of strings.
+*/
+class TraderTable
+{
+private:
+	std::unordered_map<std::string, int> mIds;
+	std::vector<std::string> mNames;
+public:
+	using Id = int;
+
+	int intern(const std::string& name)
+	{
+		auto it = mIds.find(name);
+		if (it != mIds.end())
+			return it->second;
+
+		int trader = static_cast<int>(mNames.size());
+		mNames.push_back(name);
+		mIds.emplace(name, trader);
+		return trader;
+	}
+
+	const std::string& name(int trader) const
+	{
+		return mNames[trader];
+	}
+};
+
+/*
+Keeps the identifier string itself in every order: no table to maintain, but a string copy per order and fill.
+*/
+struct StringIds
+{
+	using Id = std::string;
+
+	const std::string& intern(const std::string& name) const
+	{
+		return name;
+	}
+
+	const std::string& name(const std::string& trader) const
+	{
+		return trader;
+	}
+};
+
+/*
+FIFO of the orders at one price as a std::queue over a deque carved from bookArena(), which can also be walked
+front to back for the book dump, the auction and the invariant checks.
+A deque frees its blocks as it drains but keeps the block map it grew to, so the level remembers the most orders it
+held since its storage was last built; compact() rebuilds it for the orders it holds now.
+*/
+template <typename Order>
+class DequeLevel : public std::queue<Order, std::deque<Order, ArenaAllocator<Order> > >
+{
+private:
+	using Base = std::queue<Order, std::deque<Order, ArenaAllocator<Order> > >;
+
+	std::size_t mPeak = 0;
+
+	// deque blocks holding count orders, taking libstdc++'s 512-byte blocks as typical
+	static std::size_t blocks(std::size_t count)
+	{
+		return count * sizeof(Order) / 512 + 1;
+	}
+public:
+	using const_iterator = typename std::deque<Order, ArenaAllocator<Order> >::const_iterator;
+
+	void push(const Order& order)
+	{
+		Base::push(order);
+		mPeak = std::max(mPeak, this->size());
+	}
+
+	void push(Order&& order)
+	{
+		Base::push(std::move(order));
+		mPeak = std::max(mPeak, this->size());
+	}
+
+	/*
+	Whether compact() would release memory: the level once spanned more blocks than it needs now.
+	*/
+	bool shrinkable() const
+	{
+		return blocks(mPeak) > blocks(this->size());
+	}
+
+	/*
+	Moves the orders, in order, into fresh storage sized for them.
+	*/
+	void compact()
+	{
+		DequeLevel fresh;
+		for (; !this->empty(); this->pop())
+			fresh.push(std::move(this->front()));
+		std::swap(*this, fresh);
+	}
+
+	const_iterator begin() const
+	{
+		return this->c.begin();
+	}
+
+	const_iterator end() const
+	{
+		return this->c.end();
+	}
+};
+
+/*
+FIFO of the orders at one price with the interface of DequeLevel. A vector with a moving head: filled orders are
+skipped rather than erased, and the storage is reused once the level runs empty. Unlike a deque, an empty level
+allocates nothing, which is what a book with a level per tick needs.
+*/
+template <typename Order>
+class FifoLevel
+{
+private:
+	std::vector<Order, ArenaAllocator<Order> > mOrders;
+	std::size_t mHead = 0;
+public:
+	using value_type = Order;
+	using const_iterator = typename std::vector<Order, ArenaAllocator<Order> >::const_iterator;
+
+	bool empty() const
+	{
+		return mHead == mOrders.size();
+	}
+
+	std::size_t size() const
+	{
+		return mOrders.size() - mHead;
+	}
+
+	Order& front()
+	{
+		return mOrders[mHead];
+	}
+
+	const Order& front() const
+	{
+		return mOrders[mHead];
+	}
+
+	Order& back()
+	{
+		return mOrders.back();
+	}
+
+	const Order& back() const
+	{
+		return mOrders.back();
+	}
+
+	const_iterator begin() const
+	{
+		return mOrders.begin() + mHead;
+	}
+
+	const_iterator end() const
+	{
+		return mOrders.end();
+	}
+
+	void pop()
+	{
+		if (++mHead == mOrders.size())
+		{
+			mOrders.clear();
+			mHead = 0;
+		}
+		else if (mHead >= 64 && mHead * 2 >= mOrders.size())
+		{
+			// a long lived level would otherwise keep every filled order
+			mOrders.erase(mOrders.begin(), mOrders.begin() + mHead);
+			mHead = 0;
+		}
+	}
+
+	void push(const Order& order)
+	{
+		mOrders.push_back(order);
+	}
+
+	void push(Order&& order)
+	{
+		mOrders.push_back(std::move(order));
+	}
+
+	/*
+	Whether compact() would release memory: filled orders or unused capacity are left.
+	*/
+	bool shrinkable() const
+	{
+		return mHead > 0 || mOrders.capacity() > mOrders.size();
+	}
+
+	/*
+	Moves the orders, in order, into storage of exactly their number.
+	*/
+	void compact()
+	{
+		std::vector<Order, ArenaAllocator<Order> > fresh;
+		fresh.reserve(size());
+		std::move(mOrders.begin() + mHead, mOrders.end(), std::back_inserter(fresh));
+		mOrders.swap(fresh);
+		mHead = 0;
+	}
+};
+
+/*
+Both sides as ordered maps from price to level, best price first, nodes and levels carved from bookArena().
+Any price is accepted. This is the book the engine ships with.
+A book type offers, with side 'B' or 'S':
+accepts(price)      - whether the book can hold an order at price;
+empty, bestPrice    - about the best level of a side, best and popBest to use it up and remove it once empty;
+prefetchNext        - a hint that the level after the best is about to be used;
+add(order)          - puts order at the back of its level;
+find(side, price)   - the level at price, nullptr if there is none;
+depth(side)         - the number of levels;
+forEach(side, f)    - calls f(price, level) for the levels best first, for as long as f returns true.
+*/
+struct MapBook
+{
+	template <typename Order>
+	class Type
+	{
+	public:
+		using Level = DequeLevel<Order>;
+	private:
+		template <typename Compare>
+		using Side = std::map<int, Level, Compare, ArenaAllocator<std::pair<const int, Level> > >;
+
+		Side<std::greater<int> > mBids;
+		Side<std::less<int> > mAsks;
+
+		template <typename Levels, typename F>
+		static void walk(Levels& levels, F& f)
+		{
+			for (auto& level : levels)
+				if (!f(level.first, level.second))
+					return;
+		}
+
+		template <typename Levels>
+		static const Level* findIn(const Levels& levels, int price)
+		{
+			auto level = levels.find(price);
+			return level == levels.end() ? nullptr : &level->second;
+		}
+
+		/*
+		Walking the book is a chain of dependent loads: a map node, then the deque block its front order lives in,
+		then the next node. When the match loop enters a level it prefetches the node of the level after it, so that
+		miss overlaps with filling the current level. The successor's address comes from the tree links, the level
+		inside it is not read; prefetching its front order too would need that read, the very miss being hidden.
+		Orders inside a level are contiguous in their deque block and left to the hardware prefetcher.
+		*/
+		template <typename Levels>
+		static void prefetchSecond(const Levels& levels)
+		{
+			auto next = std::next(levels.begin());
+			if (next != levels.end())
+				__builtin_prefetch(&*next);
+		}
+	public:
+		static bool accepts(int)
+		{
+			return true;
+		}
+
+		bool empty(char side) const
+		{
+			return side == 'B' ? mBids.empty() : mAsks.empty();
+		}
+
+		int bestPrice(char side) const
+		{
+			return side == 'B' ? mBids.begin()->first : mAsks.begin()->first;
+		}
+
+		Level& best(char side)
+		{
+			return side == 'B' ? mBids.begin()->second : mAsks.begin()->second;
+		}
+
+		/*
+		Removes the best level of side, which must be empty by now.
+		*/
+		void popBest(char side)
+		{
+			if (side == 'B')
+				mBids.erase(mBids.begin());
+			else
+				mAsks.erase(mAsks.begin());
+		}
+
+		void prefetchNext(char side) const
+		{
+			if (side == 'B')
+				prefetchSecond(mBids);
+			else
+				prefetchSecond(mAsks);
+		}
+
+		void add(const Order& order)
+		{
+			(order.side == 'B' ? mBids[order.price] : mAsks[order.price]).push(order);
+		}
+
+		const Level* find(char side, int price) const
+		{
+			return side == 'B' ? findIn(mBids, price) : findIn(mAsks, price);
+		}
+
+		std::size_t depth(char side) const
+		{
+			return side == 'B' ? mBids.size() : mAsks.size();
+		}
+
+		template <typename F>
+		void forEach(char side, F f)
+		{
+			if (side == 'B')
+				walk(mBids, f);
+			else
+				walk(mAsks, f);
+		}
+
+		template <typename F>
+		void forEach(char side, F f) const
+		{
+			if (side == 'B')
+				walk(mBids, f);
+			else
+				walk(mAsks, f);
+		}
+	};
+};
+
+/*
+Both sides as one level per tick in [MinPrice, MaxPrice], indexed by price, with the best level tracked.
+Adding is O(1) and finding the next best level after one empties is a scan over the ticks in between, which is
+short when the book is dense near the touch. Prices outside the band are rejected.
+*/
+template <int MinPrice, int MaxPrice>
+struct ArrayBook
+{
+	static_assert(MinPrice <= MaxPrice, "empty price band");
+
+	template <typename Order>
+	class Type
+	{
+	public:
+		using Level = FifoLevel<Order>;
+	private:
+		static const int Ticks = MaxPrice - MinPrice + 1;
+
+		std::vector<Level> mLevels[2]; // bids, asks
+		int mBest[2]; // index of the best non-empty level, -1 if the side is empty
+		int mEdge[2]; // index of the level furthest from the best that ever held an order, bounds the scans
+		std::size_t mDepth[2]; // non-empty levels
+
+		static int index(char side)
+		{
+			return side == 'B' ? 0 : 1;
+		}
+
+		template <typename Self, typename F>
+		static void walk(Self& self, int s, F& f)
+		{
+			if (self.mBest[s] == -1)
+				return;
+
+			int step = s == 0 ? -1 : 1;
+			for (int tick = self.mBest[s]; tick != self.mEdge[s] + step; tick += step)
+				if (!self.mLevels[s][tick].empty() && !f(MinPrice + tick, self.mLevels[s][tick]))
+					return;
+		}
+	public:
+		Type() : mBest{ -1, -1 }, mEdge{ -1, -1 }, mDepth{ 0, 0 }
+		{
+			mLevels[0].resize(Ticks);
+			mLevels[1].resize(Ticks);
+		}
+
+		static bool accepts(int price)
+		{
+			return price >= MinPrice && price <= MaxPrice;
+		}
+
+		bool empty(char side) const
+		{
+			return mBest[index(side)] == -1;
+		}
+
+		int bestPrice(char side) const
+		{
+			return MinPrice + mBest[index(side)];
+		}
+
+		Level& best(char side)
+		{
+			return mLevels[index(side)][mBest[index(side)]];
+		}
+
+		/*
+		Moves the best level of side on to the next non-empty one; the current one must be empty by now.
+		*/
+		void popBest(char side)
+		{
+			int s = index(side);
+			std::vector<Level>& levels = mLevels[s];
+			int& best = mBest[s];
+			--mDepth[s];
+
+			if (s == 0)
+			{
+				while (--best >= mEdge[s] && levels[best].empty())
+					;
+				if (best < mEdge[s])
+					best = -1;
+			}
+			else
+			{
+				while (++best <= mEdge[s] && levels[best].empty())
+					;
+				if (best > mEdge[s])
+					best = -1;
+			}
+		}
+
+		/*
+		Levels sit next to each other in the tick array, the hardware prefetcher already follows the scan.
+		*/
+		void prefetchNext(char) const
+		{
+
+		}
+
+		void add(const Order& order)
+		{
+			int s = index(order.side);
+			int tick = order.price - MinPrice;
+			Level& level = mLevels[s][tick];
+			if (level.empty())
+				++mDepth[s];
+			level.push(order);
+
+			if (mBest[s] == -1 || (s == 0 ? tick > mBest[s] : tick < mBest[s]))
+				mBest[s] = tick;
+			if (mEdge[s] == -1 || (s == 0 ? tick < mEdge[s] : tick > mEdge[s]))
+				mEdge[s] = tick;
+		}
+
+		const Level* find(char side, int price) const
+		{
+			if (!accepts(price))
+				return nullptr;
+			const Level& level = mLevels[index(side)][price - MinPrice];
+			return level.empty() ? nullptr : &level;
+		}
+
+		std::size_t depth(char side) const
+		{
+			return mDepth[index(side)];
+		}
+
+		template <typename F>
+		void forEach(char side, F f)
+		{
+			walk(*this, index(side), f);
+		}
+
+		template <typename F>
+		void forEach(char side, F f) const
+		{
+			walk(*this, index(side), f);
+		}
+	};
+};
+
+/*
+Sort key of a trade that orders like its text "<Trader><Sign><Quantity>@<Price>" does.
+Trader identifiers are alphanumeric, so comparing "<Trader><Sign>" texts is the same as comparing the ranks of
+the traders by name (among those of the execution) and then signs ('+' < '-'). The rest, "<Quantity>@<Price>",
+is packed one character per nibble ('-' -> 1, digits -> 2..11, '@' -> 12, 0 past the end), which preserves the
+character order: hi = rank:32 | sign:1 | first 7 characters | 000, lo = next 16 characters.
+23 characters cover any int pair.
+*/
+struct TradeKey
+{
+	std::uint64_t hi;
+	std::uint64_t lo;
+	std::uint32_t index;
+
+	bool operator<(const TradeKey& other) const
+	{
+		return hi != other.hi ? hi < other.hi : lo < other.lo;
+	}
+};
+
+template <typename Trade>
+TradeKey makeTradeKey(const Trade& trade, std::uint32_t rank, std::uint32_t index)
+{
+	char text[32];
+	char* end = std::to_chars(text, text + 11, trade.quantity).ptr; // at most 10 digits and a sign
+	*end++ = '@';
+	end = std::to_chars(end, text + sizeof(text), trade.price).ptr;
+
+	std::uint64_t nibbles[23] = {};
+	for (std::size_t i = 0; text + i < end; ++i)
+		nibbles[i] = text[i] == '-' ? 1 : text[i] == '@' ? 12 : static_cast<std::uint64_t>(text[i] - '0') + 2;
+
+	TradeKey key{ static_cast<std::uint64_t>(rank) << 32 | static_cast<std::uint64_t>(trade.sign == '-') << 31, 0, index };
+	for (int i = 0; i < 7; ++i)
+		key.hi |= nibbles[i] << (27 - 4 * i);
+	for (int i = 0; i < 16; ++i)
+		key.lo |= nibbles[7 + i] << (60 - 4 * i);
+	return key;
+}
+
+/*
+LSD radix sort of keys, one byte per pass, skipping the bytes all keys agree on
+(typically most of the rank and the tail of the text).
+*/
+inline void radixSort(std::vector<TradeKey>& keys)
+{
+	std::vector<TradeKey> buffer(keys.size());
+	std::uint64_t diff[2] = { 0, 0 };
+	for (const TradeKey& key : keys)
+	{
+		diff[0] |= key.lo ^ keys[0].lo;
+		diff[1] |= key.hi ^ keys[0].hi;
+	}
+
+	for (int pass = 0; pass < 16; ++pass)
+	{
+		int word = pass / 8, shift = (pass % 8) * 8;
+		if (((diff[word] >> shift) & 0xff) == 0)
+			continue;
+
+		std::size_t count[257] = {};
+		for (const TradeKey& key : keys)
+			++count[(((word ? key.hi : key.lo) >> shift) & 0xff) + 1];
+		for (int i = 0; i < 256; ++i)
+			count[i + 1] += count[i];
+		for (const TradeKey& key : keys)
+			buffer[count[((word ? key.hi : key.lo) >> shift) & 0xff]++] = key;
+		keys.swap(buffer);
+	}
+}
+
+/*
+Sorts the trades of one execution into the reported order (by trader, sign and price as text).
+Executions usually produce a handful of trades, those are insertion sorted; large sweeps are radix sorted.
+*/
+template <typename Trade, typename IdPolicy>
+void sortTrades(std::vector<Trade>& trades, const IdPolicy& traders)
+{
+	using Id = typename IdPolicy::Id;
+	if (trades.size() < 2)
+		return;
+
+	// rank only the traders of this execution by name, usually a few of them
+	std::vector<Id> ids;
+	ids.reserve(trades.size());
+	for (const Trade& trade : trades)
+		ids.push_back(trade.trader);
+	std::sort(ids.begin(), ids.end());
+	ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+	std::vector<Id> byName(ids);
+	std::sort(byName.begin(), byName.end(), [&traders](const Id& a, const Id& b) { return traders.name(a) < traders.name(b); });
+	std::vector<std::uint32_t> ranks(ids.size());
+	for (std::size_t rank = 0; rank < byName.size(); ++rank)
+		ranks[std::lower_bound(ids.begin(), ids.end(), byName[rank]) - ids.begin()] = static_cast<std::uint32_t>(rank);
+
+	std::vector<TradeKey> keys;
+	keys.reserve(trades.size());
+	for (std::size_t i = 0; i < trades.size(); ++i)
+	{
+		std::uint32_t rank = ranks[std::lower_bound(ids.begin(), ids.end(), trades[i].trader) - ids.begin()];
+		keys.push_back(makeTradeKey(trades[i], rank, static_cast<std::uint32_t>(i)));
+	}
+
+	if (keys.size() <= 32)
+	{
+		for (std::size_t i = 1; i < keys.size(); ++i)
+		{
+			TradeKey key = keys[i];
+			std::size_t j = i;
+			for (; j > 0 && key < keys[j - 1]; --j)
+				keys[j] = keys[j - 1];
+			keys[j] = key;
+		}
+	}
+	else
+		radixSort(keys);
+
+	std::vector<Trade> sorted;
+	sorted.reserve(trades.size());
+	for (const TradeKey& key : keys)
+		sorted.push_back(trades[key.index]);
+	trades.swap(sorted);
+}
+
+/*
+Appends "<Trader><Sign><Quantity>@<Price>" to out.
+*/
+template <typename Trade, typename IdPolicy>
+void appendTrade(std::string& out, const Trade& trade, const IdPolicy& traders)
+{
+	char number[16];
+	out += traders.name(trade.trader);
+	out += trade.sign;
+	out.append(number, std::to_chars(number, number + sizeof(number), trade.quantity).ptr);
+	out += '@';
+	out.append(number, std::to_chars(number, number + sizeof(number), trade.price).ptr);
+}
+
+/*
+Renders every execution as one line "<Trader><Sign><Quantity>@<Price> ..." in the order of the text,
+as the assignment asks.
+*/
+class TextReporter
+{
+public:
+	template <typename IdPolicy, typename Trade>
+	void execution(const IdPolicy& traders, std::vector<Trade>& trades, std::string& out)
+	{
+		sortTrades(trades, traders);
+		for (const Trade& trade : trades)
+		{
+			appendTrade(out, trade, traders);
+			out += ' ';
+		}
+		out += '\n';
+	}
+};
+
+/*
+One trade as written by BinaryReporter: 32 bytes in host byte order, the trades of one execution share execution.
+*/
+struct BinaryTradeRecord
+{
+	std::uint64_t execution;
+	std::int32_t quantity; // positive for bought, negative for sold
+	std::int32_t price;
+	char trader[16]; // zero padded, truncated past 16 characters
+};
+
+/*
+Renders executions as BinaryTradeRecords, unsorted, for consumers that do not want to parse text.
+*/
+class BinaryReporter
+{
+private:
+	std::uint64_t mExecutions = 0;
+public:
+	template <typename IdPolicy, typename Trade>
+	void execution(const IdPolicy& traders, std::vector<Trade>& trades, std::string& out)
+	{
+		for (const Trade& trade : trades)
+		{
+			BinaryTradeRecord record;
+			std::memset(&record, 0, sizeof(record));
+			const std::string& name = traders.name(trade.trader);
+			record.execution = mExecutions;
+			record.quantity = trade.sign == '+' ? trade.quantity : -trade.quantity;
+			record.price = trade.price;
+			std::memcpy(record.trader, name.data(), std::min(name.size(), sizeof(record.trader)));
+			out.append(reinterpret_cast<const char*>(&record), sizeof(record));
+		}
+		++mExecutions;
+	}
+};
@@ -0,0 +1,300 @@
+#pragma once
+#include <cerrno>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/*
+Line based order gateway for Linux. Accepts any number of clients on a Unix-domain socket ("unix:<path>")
+or on a loopback TCP port ("tcp:<port>"), reads newline terminated requests with a non-blocking epoll loop
+and lets the owner of the gateway write lines back to particular connections.
+Everything runs on the calling thread, so the line callback may call into the matching engine directly.
+*/
+class OrderGateway {
+private:
+	struct Connection {
+		std::string mIn;   // bytes received but not yet split into lines
+		std::string mOut;  // bytes accepted by send() but not yet written to the socket
+		bool mWantWrite = false;
+	};
+
+	int mListenFd;
+	int mEpollFd;
+	std::string mUnixPath;
+	std::unordered_map<int, Connection> mConnections;
+
+	static volatile std::sig_atomic_t& stopFlag()
+	{
+		static volatile std::sig_atomic_t flag = 0;
+		return flag;
+	}
+
+	static void onSignal(int)
+	{
+		stopFlag() = 1;
+	}
+
+	bool listenUnix(const std::string& path)
+	{
+		sockaddr_un addr{};
+		if (path.size() >= sizeof(addr.sun_path))
+			return false;
+
+		mListenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+		if (mListenFd == -1)
+			return false;
+
+		addr.sun_family = AF_UNIX;
+		std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+		unlink(path.c_str());
+		if (bind(mListenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1)
+			return false;
+
+		mUnixPath = path;
+		return true;
+	}
+
+	bool listenTcp(int port)
+	{
+		mListenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+		if (mListenFd == -1)
+			return false;
+
+		int one = 1;
+		setsockopt(mListenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+		sockaddr_in addr{};
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons(static_cast<std::uint16_t>(port));
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		return bind(mListenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != -1;
+	}
+
+	void updateInterest(int fd, Connection& conn)
+	{
+		bool wantWrite = !conn.mOut.empty();
+		if (wantWrite == conn.mWantWrite)
+			return;
+
+		epoll_event ev{};
+		ev.events = EPOLLIN | EPOLLRDHUP | (wantWrite ? EPOLLOUT : 0u);
+		ev.data.fd = fd;
+		epoll_ctl(mEpollFd, EPOLL_CTL_MOD, fd, &ev);
+		conn.mWantWrite = wantWrite;
+	}
+
+	void acceptAll()
+	{
+		for (;;)
+		{
+			int fd = accept4(mListenFd, nullptr, nullptr, SOCK_NONBLOCK);
+			if (fd == -1)
+				return; // EAGAIN: backlog drained, anything else: try again on the next event
+
+			int one = 1;
+			setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); // fails harmlessly on Unix sockets
+
+			epoll_event ev{};
+			ev.events = EPOLLIN | EPOLLRDHUP;
+			ev.data.fd = fd;
+			if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, fd, &ev) == -1)
+			{
+				::close(fd);
+				continue;
+			}
+			mConnections[fd];
+		}
+	}
+
+	/*
+	Writes as much of the pending output as the socket takes. Returns false if the connection broke.
+	*/
+	bool flush(int fd, Connection& conn)
+	{
+		std::size_t written = 0;
+		while (written < conn.mOut.size())
+		{
+			ssize_t n = ::send(fd, conn.mOut.data() + written, conn.mOut.size() - written, MSG_NOSIGNAL);
+			if (n > 0)
+				written += static_cast<std::size_t>(n);
+			else if (n == -1 && errno == EINTR)
+				continue;
+			else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+				break;
+			else
+				return false;
+		}
+
+		conn.mOut.erase(0, written);
+		updateInterest(fd, conn);
+		return true;
+	}
+
+	/*
+	Reads everything available and hands complete lines to onLine. Returns false if the peer is gone.
+	*/
+	template <typename OnLine>
+	bool receive(int fd, OnLine& onLine)
+	{
+		char buffer[1 << 16];
+		for (;;)
+		{
+			ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+			if (n == 0)
+				return false;
+			if (n == -1)
+			{
+				if (errno == EINTR)
+					continue;
+				return errno == EAGAIN || errno == EWOULDBLOCK;
+			}
+
+			std::string& in = mConnections[fd].mIn;
+			in.append(buffer, static_cast<std::size_t>(n));
+
+			std::size_t begin = 0, end;
+			while ((end = in.find('\n', begin)) != std::string::npos)
+			{
+				onLine(fd, in.data() + begin, end - begin);
+				begin = end + 1;
+			}
+			in.erase(0, begin);
+		}
+	}
+
+	void close(int fd)
+	{
+		epoll_ctl(mEpollFd, EPOLL_CTL_DEL, fd, nullptr);
+		::close(fd);
+		mConnections.erase(fd);
+	}
+public:
+	/*
+	Constructs a gateway listening on address, "unix:<path>" or "tcp:<port>".
+	Use ok() to check whether the socket could be set up.
+	*/
+	explicit OrderGateway(const std::string& address) : mListenFd(-1), mEpollFd(-1)
+	{
+		bool bound = false;
+		if (address.compare(0, 5, "unix:") == 0)
+			bound = listenUnix(address.substr(5));
+		else if (address.compare(0, 4, "tcp:") == 0)
+			bound = listenTcp(std::atoi(address.c_str() + 4));
+
+		if (!bound || listen(mListenFd, SOMAXCONN) == -1)
+		{
+			if (mListenFd != -1)
+				::close(mListenFd);
+			mListenFd = -1;
+			return;
+		}
+
+		mEpollFd = epoll_create1(0);
+		epoll_event ev{};
+		ev.events = EPOLLIN;
+		ev.data.fd = mListenFd;
+		epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mListenFd, &ev);
+	}
+
+	OrderGateway(const OrderGateway&) = delete;
+	OrderGateway& operator=(const OrderGateway&) = delete;
+
+	bool ok() const
+	{
+		return mListenFd != -1 && mEpollFd != -1;
+	}
+
+	/*
+	Queues line (which must include its trailing newline) for the connection conn and tries to write it right away.
+	Lines for connections that are already closed are dropped.
+	*/
+	void send(int conn, const std::string& line)
+	{
+		auto it = mConnections.find(conn);
+		if (it == mConnections.end())
+			return;
+
+		// a broken connection is reported by epoll as well, it is closed from the event loop then,
+		// so that callers iterating over received data never see it disappear
+		it->second.mOut += line;
+		if (!it->second.mWantWrite && !flush(conn, it->second))
+			it->second.mOut.clear();
+	}
+
+	/*
+	Runs the event loop until SIGINT or SIGTERM. onLine(int conn, const char* line, std::size_t length) is called
+	for every received line, without the newline; onClose(int conn) after a client disconnected.
+	*/
+	template <typename OnLine, typename OnClose>
+	void run(OnLine onLine, OnClose onClose)
+	{
+		struct sigaction sa{};
+		sa.sa_handler = onSignal;
+		sigaction(SIGINT, &sa, nullptr); // no SA_RESTART, so epoll_wait returns with EINTR
+		sigaction(SIGTERM, &sa, nullptr);
+
+		std::vector<epoll_event> events(256);
+		while (!stopFlag())
+		{
+			int n = epoll_wait(mEpollFd, events.data(), static_cast<int>(events.size()), -1);
+			if (n == -1)
+			{
+				if (errno == EINTR)
+					continue;
+				std::cerr << "epoll_wait: " << std::strerror(errno) << '\n';
+				return;
+			}
+
+			for (int i = 0; i < n; ++i)
+			{
+				int fd = events[i].data.fd;
+				if (fd == mListenFd)
+				{
+					acceptAll();
+					continue;
+				}
+
+				auto it = mConnections.find(fd);
+				if (it == mConnections.end())
+					continue;
+
+				bool alive = true;
+				if (events[i].events & EPOLLOUT)
+					alive = flush(fd, it->second);
+				if (alive && (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)))
+					alive = receive(fd, onLine) && !(events[i].events & (EPOLLHUP | EPOLLERR));
+
+				if (!alive)
+				{
+					close(fd);
+					onClose(fd);
+				}
+			}
+		}
+	}
+
+	~OrderGateway()
+	{
+		for (auto& conn : mConnections)
+			::close(conn.first);
+		if (mEpollFd != -1)
+			::close(mEpollFd);
+		if (mListenFd != -1)
+			::close(mListenFd);
+		if (!mUnixPath.empty())
+			unlink(mUnixPath.c_str());
+	}
+};
@@ -0,0 +1,130 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <utility>
+
+/*
+Bounded lock-free multi-producer single-consumer queue (Vyukov's array queue with the consumer side simplified).
+Every cell carries a sequence number telling whether it is free for the producer holding ticket pos (sequence == pos)
+or filled and ready for the consumer (sequence == pos + 1). Producers claim tickets with a CAS on mEnqueuePos,
+so the ticket doubles as a global arrival stamp: the consumer always sees elements in ticket order.
+*/
+template <typename T>
+class IngressQueue {
+private:
+	struct Cell {
+		std::atomic<std::uint64_t> mSequence;
+		T mData;
+	};
+
+	Cell* mCells;
+	std::size_t mMask;
+
+	alignas(64) std::atomic<std::uint64_t> mEnqueuePos;
+	alignas(64) std::uint64_t mDequeuePos;
+
+	// backpressure metrics, relaxed counters
+	alignas(64) std::atomic<std::uint64_t> mProducerStalls;
+	std::atomic<std::uint64_t> mConsumerStalls;
+public:
+	struct Stats {
+		std::uint64_t enqueued;
+		std::uint64_t producerStalls; // failed pushes because the queue was full
+		std::uint64_t consumerStalls; // failed pops because the queue was empty
+	};
+
+	/*
+	Constructs a queue able to hold capacity elements. capacity must be a power of two.
+	*/
+	explicit IngressQueue(std::size_t capacity)
+		: mCells(new Cell[capacity]), mMask(capacity - 1), mEnqueuePos(0), mDequeuePos(0), mProducerStalls(0), mConsumerStalls(0)
+	{
+		assert(capacity >= 2 && (capacity & (capacity - 1)) == 0);
+		for (std::size_t i = 0; i < capacity; ++i)
+			mCells[i].mSequence.store(i, std::memory_order_relaxed);
+	}
+
+	IngressQueue(const IngressQueue&) = delete;
+	IngressQueue& operator=(const IngressQueue&) = delete;
+
+	/*
+	Tries to append value. On success stores the enqueue ticket in seq and returns true, returns false if the queue is full.
+	Safe to call from any number of threads.
+	*/
+	bool try_push(T& value, std::uint64_t& seq)
+	{
+		std::uint64_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			Cell& cell = mCells[pos & mMask];
+			std::uint64_t cellSeq = cell.mSequence.load(std::memory_order_acquire);
+			std::int64_t diff = static_cast<std::int64_t>(cellSeq - pos);
+
+			if (diff == 0)
+			{
+				if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					cell.mData = std::move(value);
+					cell.mSequence.store(pos + 1, std::memory_order_release);
+					seq = pos;
+					return true;
+				}
+			}
+			else if (diff < 0)
+				return false;
+			else
+				pos = mEnqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	/*
+	Appends value, yielding while the queue is full. Returns the enqueue ticket.
+	*/
+	std::uint64_t push(T value)
+	{
+		std::uint64_t seq;
+		while (!try_push(value, seq))
+		{
+			mProducerStalls.fetch_add(1, std::memory_order_relaxed);
+			std::this_thread::yield();
+		}
+		return seq;
+	}
+
+	/*
+	Tries to take the oldest element and its enqueue ticket. Returns false if the queue is empty.
+	Must only be called from the consumer thread.
+	*/
+	bool try_pop(T& value, std::uint64_t& seq)
+	{
+		Cell& cell = mCells[mDequeuePos & mMask];
+		if (cell.mSequence.load(std::memory_order_acquire) != mDequeuePos + 1)
+		{
+			mConsumerStalls.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		value = std::move(cell.mData);
+		seq = mDequeuePos;
+		cell.mSequence.store(mDequeuePos + mMask + 1, std::memory_order_release);
+		++mDequeuePos;
+		return true;
+	}
+
+	/*
+	Returns the backpressure counters. Only exact once producers are done.
+	*/
+	Stats stats() const
+	{
+		return { mEnqueuePos.load(std::memory_order_relaxed), mProducerStalls.load(std::memory_order_relaxed),
+			mConsumerStalls.load(std::memory_order_relaxed) };
+	}
+
+	~IngressQueue()
+	{
+		delete[] mCells;
+	}
+};
@@ -0,0 +1,102 @@
+#pragma once
+#include <cerrno>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/*
+CPU and NUMA placement helpers for Linux, used to keep the engine threads and the memory they touch on one node.
+The NUMA calls go through syscall() so the engine does not need libnuma.
+*/
+
+/*
+Pins the calling thread to cpu. Returns false if the cpu does not exist or is not allowed.
+*/
+inline bool pinCurrentThread(int cpu)
+{
+	if (cpu < 0 || cpu >= CPU_SETSIZE)
+	{
+		errno = EINVAL;
+		return false;
+	}
+
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	if (error)
+		errno = error;
+	return error == 0;
+}
+
+/*
+Returns the cpu and NUMA node the calling thread runs on right now.
+*/
+inline void currentPlacement(int& cpu, int& node)
+{
+	unsigned c = 0, n = 0;
+	if (syscall(SYS_getcpu, &c, &n, nullptr) == -1)
+		c = n = 0;
+	cpu = static_cast<int>(c);
+	node = static_cast<int>(n);
+}
+
+/*
+Makes the kernel place every page the calling thread faults in from now on on node, falling back to other nodes
+only when it is full (MPOL_PREFERRED). Memory is placed when first touched, so whatever the thread allocates and
+writes after this call, the book included, lands on node.
+*/
+inline bool preferNode(int node)
+{
+	const int mpolPreferred = 1; // MPOL_PREFERRED from <numaif.h>
+	if (node < 0 || node >= static_cast<int>(8 * sizeof(unsigned long)))
+		return false;
+
+	unsigned long mask = 1ul << node;
+	return syscall(SYS_set_mempolicy, mpolPreferred, &mask, 8 * sizeof(mask) + 1) == 0;
+}
+
+/*
+Returns "cpu <c> (node <n>)" for the calling thread, for startup reporting.
+*/
+inline std::string describePlacement()
+{
+	int cpu, node;
+	currentPlacement(cpu, node);
+	return "cpu " + std::to_string(cpu) + " (node " + std::to_string(node) + ")";
+}
+
+/*
+Which cpus the engine threads run on, -1 or empty for "leave it to the scheduler".
+*/
+struct PlacementOptions
+{
+	int matchCpu = -1;
+	std::vector<int> parseCpus; // gateway thread i runs on parseCpus[i % size]
+	int outputCpu = -1;
+};
+
+/*
+Parses a comma separated cpu list like "2,3,6". Returns false on anything else.
+*/
+inline bool parseCpuList(const char* text, std::vector<int>& cpus)
+{
+	cpus.clear();
+	while (*text)
+	{
+		char* end;
+		errno = 0;
+		long cpu = std::strtol(text, &end, 10);
+		if (end == text || errno || cpu < 0 || cpu >= CPU_SETSIZE || (*end && *end != ','))
+			return false;
+
+		cpus.push_back(static_cast<int>(cpu));
+		text = *end ? end + 1 : end;
+	}
+	return !cpus.empty();
+}
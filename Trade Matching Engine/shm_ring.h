@@ -0,0 +1,305 @@
+#pragma once
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <new>
+#include <string>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/*
+Bounded multi-producer single-consumer ring of fixed-size records living in a POSIX shared memory object
+(/dev/shm/<name>), so separate processes can exchange records without a syscall per message.
+The algorithm is the one of IngressQueue: each cell has a sequence number, producers claim cells with a CAS on the
+enqueue position. T must be trivially copyable, it is copied between address spaces byte by byte.
+
+A consumer that finds the ring empty can either spin or sleep on a futex in the shared header; producers only
+issue the wake syscall when the consumer announced that it is going to sleep.
+The header records the pid of the creating process, so a process waiting on the ring can tell when the other side
+is gone instead of waiting forever.
+*/
+template <typename T>
+class ShmRing {
+private:
+	static_assert(std::is_trivially_copyable<T>::value, "ShmRing records must be trivially copyable");
+	static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "ShmRing needs address-free atomics");
+
+	static const std::uint64_t Magic = 0x4d45534852494e47ull + sizeof(T); // "MESHRING" + record size
+
+	struct Header {
+		std::uint64_t mMagic;
+		std::uint64_t mCapacity;
+		std::int32_t mCreator; // pid of the creating process
+		alignas(64) std::atomic<std::uint64_t> mEnqueuePos;
+		alignas(64) std::atomic<std::uint64_t> mDequeuePos;
+		alignas(64) std::atomic<std::uint32_t> mWakeups; // futex word, bumped on every wakeup
+		std::atomic<std::uint32_t> mSleeping;            // 1 while the consumer waits on mWakeups
+	};
+
+	struct Cell {
+		std::atomic<std::uint64_t> mSequence;
+		T mData;
+	};
+
+	Header* mHeader;
+	Cell* mCells;
+	std::size_t mBytes;
+	std::uint64_t mMask;
+	std::string mName;
+	bool mOwner;
+
+	static long futex(std::atomic<std::uint32_t>* word, int op, std::uint32_t value, const timespec* timeout = nullptr)
+	{
+		// not FUTEX_PRIVATE_FLAG: the word is shared between processes
+		return syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(word), op, value, timeout, nullptr, 0);
+	}
+
+	static std::size_t bytesFor(std::uint64_t capacity)
+	{
+		return sizeof(Header) + capacity * sizeof(Cell);
+	}
+
+	ShmRing() : mHeader(nullptr), mCells(nullptr), mBytes(0), mMask(0), mOwner(false)
+	{
+
+	}
+
+	bool map(int fd, std::size_t bytes)
+	{
+		void* addr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		::close(fd);
+		if (addr == MAP_FAILED)
+			return false;
+
+		mBytes = bytes;
+		mHeader = static_cast<Header*>(addr);
+		mCells = reinterpret_cast<Cell*>(mHeader + 1);
+		return true;
+	}
+public:
+	/*
+	Creates (or replaces) the ring name with room for capacity records. capacity must be a power of two.
+	The creator unlinks the shared memory object when it is destroyed.
+	*/
+	static ShmRing* create(const std::string& name, std::uint64_t capacity)
+	{
+		if (capacity < 2 || (capacity & (capacity - 1)) != 0)
+			return nullptr;
+
+		shm_unlink(name.c_str());
+		int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+		if (fd == -1)
+			return nullptr;
+
+		if (ftruncate(fd, static_cast<off_t>(bytesFor(capacity))) == -1)
+		{
+			::close(fd);
+			shm_unlink(name.c_str());
+			return nullptr;
+		}
+
+		ShmRing* ring = new ShmRing();
+		if (!ring->map(fd, bytesFor(capacity)))
+		{
+			delete ring;
+			shm_unlink(name.c_str());
+			return nullptr;
+		}
+
+		ring->mName = name;
+		ring->mOwner = true;
+		ring->mMask = capacity - 1;
+
+		Header* header = new (ring->mHeader) Header();
+		header->mCapacity = capacity;
+		header->mCreator = static_cast<std::int32_t>(getpid());
+		header->mEnqueuePos.store(0, std::memory_order_relaxed);
+		header->mDequeuePos.store(0, std::memory_order_relaxed);
+		header->mWakeups.store(0, std::memory_order_relaxed);
+		header->mSleeping.store(0, std::memory_order_relaxed);
+		for (std::uint64_t i = 0; i < capacity; ++i)
+			new (&ring->mCells[i].mSequence) std::atomic<std::uint64_t>(i);
+
+		// publish the magic last, openers poll for it
+		std::atomic_thread_fence(std::memory_order_release);
+		header->mMagic = Magic;
+		return ring;
+	}
+
+	/*
+	Maps an existing ring created by another process. Returns nullptr if it does not exist or holds other records.
+	*/
+	static ShmRing* open(const std::string& name)
+	{
+		int fd = shm_open(name.c_str(), O_RDWR, 0);
+		if (fd == -1)
+			return nullptr;
+
+		struct stat st;
+		if (fstat(fd, &st) == -1 || static_cast<std::size_t>(st.st_size) < sizeof(Header))
+		{
+			::close(fd);
+			return nullptr;
+		}
+
+		ShmRing* ring = new ShmRing();
+		if (!ring->map(fd, static_cast<std::size_t>(st.st_size)))
+		{
+			delete ring;
+			return nullptr;
+		}
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (ring->mHeader->mMagic != Magic || bytesFor(ring->mHeader->mCapacity) != ring->mBytes)
+		{
+			delete ring;
+			return nullptr;
+		}
+
+		ring->mName = name;
+		ring->mMask = ring->mHeader->mCapacity - 1;
+		return ring;
+	}
+
+	ShmRing(const ShmRing&) = delete;
+	ShmRing& operator=(const ShmRing&) = delete;
+
+	/*
+	Tries to append value, returns false if the ring is full. Safe to call from any number of threads and processes.
+	*/
+	bool try_push(const T& value)
+	{
+		std::uint64_t pos = mHeader->mEnqueuePos.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			Cell& cell = mCells[pos & mMask];
+			std::uint64_t cellSeq = cell.mSequence.load(std::memory_order_acquire);
+			std::int64_t diff = static_cast<std::int64_t>(cellSeq - pos);
+
+			if (diff == 0)
+			{
+				if (mHeader->mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					cell.mData = value;
+					cell.mSequence.store(pos + 1, std::memory_order_release);
+					break;
+				}
+			}
+			else if (diff < 0)
+				return false;
+			else
+				pos = mHeader->mEnqueuePos.load(std::memory_order_relaxed);
+		}
+
+		// the record was published with a release store and mSleeping is loaded next: store then load needs a full
+		// fence, paired with the consumer's between announcing its sleep and rechecking, so either it sees our
+		// record or we see it sleeping
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (mHeader->mSleeping.load(std::memory_order_relaxed))
+		{
+			mHeader->mWakeups.fetch_add(1, std::memory_order_seq_cst);
+			futex(&mHeader->mWakeups, FUTEX_WAKE, 1);
+		}
+		return true;
+	}
+
+	/*
+	Appends value, spinning while the ring is full for as long as alive() holds. alive is only asked every few
+	hundred attempts, so it may make a syscall (creator_alive(), typically). Returns false if value was dropped
+	because alive() failed.
+	*/
+	template <typename Alive>
+	bool push(const T& value, const Alive& alive)
+	{
+		for (unsigned attempts = 1; !try_push(value); ++attempts)
+		{
+			if (attempts % 256 == 0 && !alive())
+				return false;
+			sched_yield();
+		}
+		return true;
+	}
+
+	/*
+	Tries to take the oldest record. Returns false if the ring is empty. Only one consumer may call it.
+	*/
+	bool try_pop(T& value)
+	{
+		std::uint64_t pos = mHeader->mDequeuePos.load(std::memory_order_relaxed);
+		Cell& cell = mCells[pos & mMask];
+		if (cell.mSequence.load(std::memory_order_acquire) != pos + 1)
+			return false;
+
+		value = cell.mData;
+		cell.mSequence.store(pos + mMask + 1, std::memory_order_release);
+		mHeader->mDequeuePos.store(pos + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	/*
+	Takes the oldest record, waiting for one to arrive. With useFutex the consumer spins for spinLimit attempts
+	and then sleeps until a producer wakes it, otherwise it busy-polls. Returns false if stop became true first
+	(a signal handler setting stop interrupts the futex sleep; otherwise the sleep is cut every 100 ms to check it).
+	*/
+	template <typename StopFlag>
+	bool pop(T& value, bool useFutex, const StopFlag& stop, unsigned spinLimit = 1024)
+	{
+		for (unsigned spins = 0;; ++spins)
+		{
+			if (try_pop(value))
+				return true;
+			if (stop)
+				return false;
+			if (!useFutex || spins < spinLimit)
+				continue;
+
+			std::uint32_t wakeups = mHeader->mWakeups.load(std::memory_order_seq_cst);
+			mHeader->mSleeping.store(1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst); // pairs with the fence in try_push
+			if (try_pop(value))
+			{
+				mHeader->mSleeping.store(0, std::memory_order_relaxed);
+				return true;
+			}
+			timespec timeout = { 0, 100000000 };
+			futex(&mHeader->mWakeups, FUTEX_WAIT, wakeups, &timeout);
+			mHeader->mSleeping.store(0, std::memory_order_relaxed);
+			spins = 0;
+		}
+	}
+
+	/*
+	Returns the number of records the ring holds at most.
+	*/
+	std::uint64_t capacity() const
+	{
+		return mMask + 1;
+	}
+
+	/*
+	Checks whether the process that created the ring still exists.
+	*/
+	bool creator_alive() const
+	{
+		return kill(static_cast<pid_t>(mHeader->mCreator), 0) == 0 || errno == EPERM;
+	}
+
+	~ShmRing()
+	{
+		if (mHeader)
+			munmap(mHeader, mBytes);
+		if (mOwner)
+			shm_unlink(mName.c_str());
+	}
+};
@@ -1,152 +1,1999 @@
 #include <iostream>
 #include <string>
 #include <map>
-#include <set>
 #include <algorithm>
 #include <queue>
+#include <unordered_map>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <charconv>
+#include <csignal>
+#include <chrono>
+#include <deque>
+#include <random>
+#include <memory>
+#include "ingress_queue.h"
+#include "gateway.h"
+#include "shm_ring.h"
+#include "placement.h"
+#include "arena.h"
+#include "engine.h"
+#include "async_io.h"
 
+/*
+A request as parsed from the input, before it reaches the book.
+*/
 struct Request
 {
 	std::string id;
+	std::uint64_t seq; // arrival order, stamped by the ingress queue
 	char side;
 	int quantity;
 	int price;
+	int display = 0; // iceberg peak size, 0 for a plain order
+};
+
+/*
+An order in the book, and while it is matched, with its trader as kept by the session's IdPolicy.
+*/
+template <typename Id>
+struct BasicOrder
+{
+	Id trader;
+	std::uint64_t seq; // arrival order; an iceberg gets a new one whenever it is replenished
+	char side;
+	int quantity; // displayed quantity once an iceberg rests
+	int price;
+	int display; // iceberg peak size, 0 for a plain order
+	int hidden; // iceberg quantity not displayed yet
+};
+
+/*
+One reported trade: <Trader><Sign><Quantity>@<Price>.
+*/
+template <typename Id>
+struct BasicTrade
+{
+	Id trader;
+	char sign;
+	int quantity;
+	int price;
+};
+
+/*
+Whether buy() and sell() issue software prefetches; --no-prefetch turns them off for comparison.
+*/
+bool prefetchBook = true;
+
+/*
+Takes up to quantity from the order at the front of level and returns how much was taken.
+A plain order leaves the level once it is filled. An iceberg only gives its displayed quantity; once that is used up
+it is replenished from the hidden quantity and moves to the back of the level with time priority now, which is a
+pop and a push rather than a rebuild of the level. An iceberg alone in its level is consumed across as many
+slices as needed in one step, since nobody else can get between its slices.
+*/
+template <typename Level>
+int takeFront(Level& level, int quantity, std::uint64_t now)
+{
+	auto& order = level.front();
+
+	if (order.hidden > 0 && level.size() == 1 && quantity > order.quantity)
+	{
+		long long total = static_cast<long long>(order.quantity) + order.hidden;
+		int dec = static_cast<int>(std::min<long long>(quantity, total));
+		if (dec == total)
+		{
+			level.pop();
+			return dec;
+		}
+
+		// r taken from the hidden part: k whole slices and p out of the next one
+		long long r = dec - order.quantity;
+		long long k = r / order.display, p = r % order.display;
+		long long slice = std::min<long long>(order.display, order.hidden - k * order.display);
+		order.quantity = static_cast<int>(slice - p);
+		order.hidden = static_cast<int>(order.hidden - k * order.display - slice);
+		order.seq = now;
+		return dec;
+	}
 
-	friend std::istream& operator>>(std::istream& input, Request& req)
+	int dec = std::min(quantity, order.quantity);
+	order.quantity -= dec;
+	if (order.quantity > 0)
+		return dec;
+
+	if (order.hidden > 0)
 	{
-		input >> req.id >> req.side >> req.quantity >> req.price;
-		return input;
+		auto next = std::move(order);
+		level.pop();
+		next.quantity = std::min(next.display, next.hidden);
+		next.hidden -= next.quantity;
+		next.seq = now;
+		level.push(std::move(next));
 	}
-};
+	else
+		level.pop();
+	return dec;
+}
 
-void printSet(const std::set<std::string>& st)
+/*
+Checks what every request must satisfy, whatever it arrived over: a trader, a side of B or S, a positive quantity
+and a display quantity that is not negative (0 for a plain order).
+*/
+bool validRequest(const Request& req)
 {
-	for (const auto& trade : st)
-		std::cout << trade << " ";
-	std::cout << '\n';
+	return !req.id.empty() && (req.side == 'B' || req.side == 'S') && req.quantity > 0 && req.display >= 0;
 }
 
-bool buy(Request& rq, std::map<int, std::queue<Request> >& Sell)
+/*
+Parses "<Trader> <Side> <Quantity> <Price> [<Display>]" from the characters [begin, end) of one line.
+The optional display quantity makes the order an iceberg showing at most that much of its quantity at a time.
+Returns false if the line is malformed.
+*/
+bool parseRequest(const char* begin, const char* end, Request& req)
 {
-	if (Sell.empty() || Sell.begin()->first > rq.price)
+	auto skipSpaces = [&]() {
+		while (begin != end && (*begin == ' ' || *begin == '\t' || *begin == '\r'))
+			++begin;
+	};
+	auto token = [&]() {
+		skipSpaces();
+		const char* start = begin;
+		while (begin != end && *begin != ' ' && *begin != '\t' && *begin != '\r')
+			++begin;
+		return std::make_pair(start, begin);
+	};
+
+	auto id = token();
+	auto side = token();
+	auto quantity = token();
+	auto price = token();
+	auto display = token();
+	skipSpaces();
+
+	if (id.first == id.second || side.second - side.first != 1 || begin != end)
 		return false;
 
-	std::map<std::pair<std::string, int>, int> sold; // <trader, price> -> quantity
-	std::map<int, int> bought; // price -> quantity
+	req.id.assign(id.first, id.second);
+	req.side = *side.first;
+	req.display = 0;
+
+	auto q = std::from_chars(quantity.first, quantity.second, req.quantity);
+	auto p = std::from_chars(price.first, price.second, req.price);
+	if (display.first != display.second)
+	{
+		auto d = std::from_chars(display.first, display.second, req.display);
+		if (d.ec != std::errc() || d.ptr != display.second || req.display <= 0)
+			return false;
+	}
+
+	return q.ec == std::errc() && q.ptr == quantity.second && p.ec == std::errc() && p.ptr == price.second
+		&& validRequest(req);
+}
 
-	auto start = Sell.begin();
+/*
+What happens when an aggressor meets a resting order of the same trader.
+None            - trade as usual (the behaviour described in the assignment);
+CancelResting   - the resting order is removed from the book, the aggressor keeps matching;
+CancelAggressor - the remaining aggressor quantity is cancelled and does not rest;
+DecrementBoth   - both orders are reduced by the overlapping quantity, no trade is reported.
+*/
+enum class StpPolicy { None, CancelResting, CancelAggressor, DecrementBoth };
 
-	while (rq.quantity > 0 && !Sell.empty() && start->first <= rq.price)
+/*
+Applies self-trade prevention to the resting order at the front of Queue.
+Returns true if the policy consumed the step, i.e. no trade should be made against that order.
+*/
+template <typename Order, typename Level>
+bool preventSelfTrade(Order& rq, Level& Queue, StpPolicy stp)
+{
+	if (stp == StpPolicy::None || Queue.front().trader != rq.trader)
+		return false;
+
+	switch (stp)
+	{
+	case StpPolicy::CancelResting:
+		Queue.pop();
+		break;
+	case StpPolicy::CancelAggressor:
+		rq.quantity = 0;
+		break;
+	case StpPolicy::DecrementBoth:
+		rq.quantity -= takeFront(Queue, rq.quantity, rq.seq);
+		break;
+	case StpPolicy::None:
+		break;
+	}
+	return true;
+}
+
+/*
+Appends the fills an aggressor made at one level as trades: one per resting trader, with the given sign, and one for
+the aggressor. A level is only visited once per execution, so aggregating per level is aggregating per price, and
+it takes a sort of a few fills instead of a map insertion per fill. fills is left empty.
+*/
+template <typename Id, typename Order, typename Trade>
+void appendLevelTrades(std::vector<std::pair<Id, int> >& fills, const Order& rq, int price, char restingSign,
+	std::vector<Trade>& trades)
+{
+	if (fills.empty())
+		return;
+
+	std::sort(fills.begin(), fills.end());
+	int total = 0;
+	for (std::size_t i = 0; i < fills.size();)
+	{
+		const Id& trader = fills[i].first;
+		int quantity = 0;
+		for (; i < fills.size() && fills[i].first == trader; ++i)
+			quantity += fills[i].second;
+		trades.push_back({ trader, restingSign, quantity, price });
+		total += quantity;
+	}
+	trades.push_back({ rq.trader, restingSign == '-' ? '+' : '-', total, price });
+	fills.clear();
+}
+
+/*
+Matches the aggressor rq against the levels of side in book, best first, for as long as they cross its limit
+price, and appends the trades to trades. Returns true if rq was filled (or cancelled by self-trade prevention).
+*/
+template <typename Book, typename Order, typename Trade>
+bool matchSide(Order& rq, Book& book, char side, std::vector<Trade>& trades, StpPolicy stp)
+{
+	auto crosses = [&]() {
+		return !book.empty(side) && (side == 'S' ? book.bestPrice(side) <= rq.price : book.bestPrice(side) >= rq.price);
+	};
+	if (!crosses())
+		return false;
+
+	std::vector<std::pair<decltype(rq.trader), int> > fills; // <trader, quantity> at the current level
+
+	while (rq.quantity > 0 && crosses())
 	{
-		auto& Queue = start->second;
+		auto& Queue = book.best(side);
+		if (prefetchBook)
+			book.prefetchNext(side);
+
 		while (!Queue.empty() && rq.quantity > 0)
 		{
-			int dec = std::min(rq.quantity, Queue.front().quantity);
+			if (preventSelfTrade(rq, Queue, stp))
+				continue;
+
+			auto trader = Queue.front().trader;
+			int dec = takeFront(Queue, rq.quantity, rq.seq);
 			rq.quantity -= dec;
-			Queue.front().quantity -= dec;
+			fills.push_back({ std::move(trader), dec });
+		}
+
+		appendLevelTrades(fills, rq, book.bestPrice(side), side == 'S' ? '-' : '+', trades);
+
+		if (Queue.empty())
+			book.popBest(side);
+	}
+
+	return rq.quantity == 0;
+}
+
+template <typename Book, typename Order, typename Trade>
+bool buy(Order& rq, Book& book, std::vector<Trade>& trades, StpPolicy stp = StpPolicy::None)
+{
+	return matchSide(rq, book, 'S', trades, stp);
+}
+
+template <typename Book, typename Order, typename Trade>
+bool sell(Order& rq, Book& book, std::vector<Trade>& trades, StpPolicy stp = StpPolicy::None)
+{
+	return matchSide(rq, book, 'B', trades, stp);
+}
 
-			sold[{Queue.front().id, Queue.front().price}] += dec;
-			bought[Queue.front().price] += dec;
+/*
+Parses "--stp=<policy>", returns false for an unknown policy name.
+*/
+bool parseStpPolicy(const char* name, StpPolicy& stp)
+{
+	if (std::strcmp(name, "none") == 0)
+		stp = StpPolicy::None;
+	else if (std::strcmp(name, "cancel-resting") == 0)
+		stp = StpPolicy::CancelResting;
+	else if (std::strcmp(name, "cancel-aggressor") == 0)
+		stp = StpPolicy::CancelAggressor;
+	else if (std::strcmp(name, "decrement-both") == 0)
+		stp = StpPolicy::DecrementBoth;
+	else
+		return false;
+	return true;
+}
+
+/*
+A value per trader: a vector indexed by interned id, or a hash map when the ids are the strings themselves.
+Traders not seen yet read as the default value.
+*/
+template <typename Id, typename T>
+class PerTrader
+{
+private:
+	std::unordered_map<Id, T> mValues;
+	T mDefault;
+public:
+	explicit PerTrader(const T& value = T()) : mDefault(value)
+	{
+
+	}
+
+	T& operator[](const Id& trader)
+	{
+		return mValues.emplace(trader, mDefault).first->second;
+	}
+
+	template <typename F>
+	void forEach(F f)
+	{
+		for (auto& cur : mValues)
+			f(cur.first, cur.second);
+	}
+
+	template <typename F>
+	void forEach(F f) const
+	{
+		for (const auto& cur : mValues)
+			f(cur.first, cur.second);
+	}
+};
+
+template <typename T>
+class PerTrader<int, T>
+{
+private:
+	std::vector<T> mValues;
+	T mDefault;
+public:
+	explicit PerTrader(const T& value = T()) : mDefault(value)
+	{
+
+	}
+
+	T& operator[](int trader)
+	{
+		if (mValues.size() <= static_cast<std::size_t>(trader))
+			mValues.resize(trader + 1, mDefault);
+		return mValues[trader];
+	}
+
+	template <typename F>
+	void forEach(F f)
+	{
+		for (std::size_t i = 0; i < mValues.size(); ++i)
+			f(static_cast<int>(i), mValues[i]);
+	}
 
-			if (Queue.front().quantity == 0)
-				Queue.pop();
+	template <typename F>
+	void forEach(F f) const
+	{
+		for (std::size_t i = 0; i < mValues.size(); ++i)
+			f(static_cast<int>(i), mValues[i]);
+	}
+};
+
+/*
+Running statistics of a session, updated once per execution from its (already aggregated) trades,
+so they never need a second pass over the text output.
+*/
+template <typename Id>
+class SessionStats
+{
+private:
+	struct TraderStats
+	{
+		long long volume = 0;
+		long long notional = 0; // sum of quantity * price
+	};
+
+	PerTrader<Id, TraderStats> mTraders;
+	long long mVolume = 0;
+	long long mNotional = 0;
+	std::uint64_t mAggressors = 0;
+	std::uint64_t mExecutions = 0; // aggressors that traded at least once
+	std::uint64_t mLevelsTouched = 0;
+	std::size_t mMaxLevelsTouched = 0;
+	std::size_t mMaxBidLevels = 0;
+	std::size_t mMaxAskLevels = 0;
+public:
+	/*
+	Accounts for one aggressor. trades holds one aggressor trade per price level it traded at.
+	*/
+	void record(const BasicOrder<Id>& rq, const std::vector<BasicTrade<Id> >& trades)
+	{
+		++mAggressors;
+		if (trades.empty())
+			return;
+
+		std::size_t levels = 0;
+		for (const BasicTrade<Id>& trade : trades)
+		{
+			TraderStats& st = mTraders[trade.trader];
+			long long notional = static_cast<long long>(trade.quantity) * trade.price;
+			st.volume += trade.quantity;
+			st.notional += notional;
+
+			if (trade.trader == rq.trader && trade.sign == (rq.side == 'B' ? '+' : '-'))
+			{
+				++levels;
+				mVolume += trade.quantity;
+				mNotional += notional;
+			}
 		}
 
-		if (Queue.empty())
-			start = Sell.erase(start);
+		++mExecutions;
+		mLevelsTouched += levels;
+		mMaxLevelsTouched = std::max(mMaxLevelsTouched, levels);
 	}
 
-	std::set<std::string> aggressorExe;
+	/*
+	Accounts for the trades of an auction uncross, which all happen at one price and have no aggressor.
+	*/
+	void recordUncross(const std::vector<BasicTrade<Id> >& trades)
+	{
+		for (const BasicTrade<Id>& trade : trades)
+		{
+			TraderStats& st = mTraders[trade.trader];
+			long long notional = static_cast<long long>(trade.quantity) * trade.price;
+			st.volume += trade.quantity;
+			st.notional += notional;
+			if (trade.sign == '+')
+			{
+				mVolume += trade.quantity;
+				mNotional += notional;
+			}
+		}
+	}
 
-	for (const auto& cur : sold)
+	void recordDepth(std::size_t bidLevels, std::size_t askLevels)
 	{
-		std::string trade = cur.first.first + "-"; // trader-
-		trade += std::to_string(cur.second) + "@" + std::to_string(cur.first.second); // count@price
-		aggressorExe.insert(trade);
+		mMaxBidLevels = std::max(mMaxBidLevels, bidLevels);
+		mMaxAskLevels = std::max(mMaxAskLevels, askLevels);
 	}
 
-	for (const auto& cur : bought)
+	template <typename IdPolicy>
+	void print(std::ostream& output, const IdPolicy& traders) const
 	{
-		std::string trade = rq.id + "+"; // trader+
-		trade += std::to_string(cur.second) + "@" + std::to_string(cur.first); // count@price
-		aggressorExe.insert(trade);
+		output << "session: " << mAggressors << " aggressors, " << mExecutions << " executions, volume " << mVolume
+			<< ", vwap " << (mVolume ? static_cast<double>(mNotional) / mVolume : 0.0) << '\n';
+		output << "levels touched per execution: avg " << (mExecutions ? static_cast<double>(mLevelsTouched) / mExecutions : 0.0)
+			<< ", max " << mMaxLevelsTouched << "; max book depth: " << mMaxBidLevels << " bid / " << mMaxAskLevels << " ask levels\n";
+
+		std::map<std::string, const TraderStats*> byName;
+		mTraders.forEach([&](const Id& trader, const TraderStats& st) {
+			if (st.volume)
+				byName[traders.name(trader)] = &st;
+		});
+
+		for (const auto& cur : byName)
+		{
+			const TraderStats& st = *cur.second;
+			output << cur.first << ": volume " << st.volume << ", notional " << st.notional
+				<< ", vwap " << static_cast<double>(st.notional) / st.volume << '\n';
+		}
 	}
+};
+
+/*
+How a session trades, set from the command line.
+*/
+struct SessionOptions
+{
+	StpPolicy stp = StpPolicy::None;
+	bool auction = false; // collect orders without matching, uncross() at the end
+	std::uint64_t footprintEvery = 0; // report the book footprint every that many requests, 0 for never
+	bool compactIdle = false; // compactBook() when the input runs dry and the book has enough slack
+};
 
-	if (!aggressorExe.empty())
-		printSet(aggressorExe);
+/*
+State of one trading session: the book, the traders, the reporter and the running statistics. The session is a
+template over the policies of engine.h, and everything that works on it below (matching, resting, the auction,
+the statistics and checks, the transports) is written once against their interfaces.
+*/
+template <typename BookPolicy, typename IdPolicy, typename ReporterPolicy>
+struct Session : SessionOptions
+{
+	using Id = typename IdPolicy::Id;
+	using Order = BasicOrder<Id>;
+	using Trade = BasicTrade<Id>;
+	using Book = typename BookPolicy::template Type<Order>;
+	using Level = typename Book::Level;
 
-	return rq.quantity == 0;
+	Book book;
+	IdPolicy traders;
+	ReporterPolicy reporter;
+	SessionStats<Id> stats;
+	std::uint64_t seq = 0; // next arrival stamp for transports without their own
+	std::uint64_t sinceFootprint = 0;
+	std::uint64_t sinceCompactCheck = 0;
+};
+
+/*
+The engines --engine= selects from; MapEngine is the default.
+*/
+using MapEngine = Session<MapBook, TraderTable, TextReporter>;
+using ArrayEngine = Session<ArrayBook<0, (1 << 17) - 1>, TraderTable, TextReporter>;
+using StringIdEngine = Session<MapBook, StringIds, TextReporter>;
+using BinaryEngine = Session<MapBook, TraderTable, BinaryReporter>;
+
+/*
+Memory held by the book, from the allocation counters of the arena allocator: orderBytes are the blocks the
+orders live in, indexBytes the deques' block maps, levelBytes the map nodes (everything else the book allocated).
+Identifiers longer than the small string buffer add heap memory that is not counted.
+*/
+struct BookFootprint
+{
+	std::size_t levels;
+	std::size_t orders;
+	std::size_t orderSize;
+	std::size_t levelBytes;
+	std::size_t orderBytes;
+	std::size_t indexBytes;
+
+	/*
+	Bytes of order storage not holding an order: the unused ends of deque blocks.
+	*/
+	std::size_t slack() const
+	{
+		return orderBytes - orders * orderSize;
+	}
+
+	void print(std::ostream& output) const
+	{
+		const double kb = 1 << 10;
+		output << "book: " << levels << " levels, " << orders << " orders; " << (levelBytes + orderBytes + indexBytes) / kb
+			<< " KB (levels " << levelBytes / kb << ", orders " << orderBytes / kb << " of which slack " << slack() / kb
+			<< ", block maps " << indexBytes / kb << ")\n";
+	}
+};
+
+template <typename Engine>
+BookFootprint measureBook(const Engine& session)
+{
+	using Order = typename Engine::Order;
+	BookFootprint footprint{ session.book.depth('B') + session.book.depth('S'), 0, sizeof(Order), 0,
+		ArenaAllocator<Order>::liveBytes(), ArenaAllocator<Order*>::liveBytes() };
+	for (char side : { 'B', 'S' })
+		session.book.forEach(side, [&](int, const typename Engine::Level& level) {
+			footprint.orders += level.size();
+			return true;
+		});
+
+	footprint.levelBytes = bookArena().stats().live - footprint.orderBytes - footprint.indexBytes;
+	return footprint;
+}
+
+/*
+Rebuilds the levels that would shrink into fresh storage sized for the orders they hold now, releasing the blocks
+and the oversized block maps left behind by levels that once were deep. Order and priority inside a level are kept.
+Levels already compacted, or too shallow to shrink, are left alone, as are map nodes, which have no slack.
+Returns the number of bytes released.
+*/
+template <typename Engine>
+std::size_t compactBook(Engine& session)
+{
+	using Level = typename Engine::Level;
+	std::size_t before = bookArena().stats().live;
+	for (char side : { 'B', 'S' })
+		session.book.forEach(side, [](int, Level& level) {
+			if (level.shrinkable())
+				level.compact();
+			return true;
+		});
+	return before - bookArena().stats().live;
+}
+
+/*
+Prints the footprint every footprintEvery requests.
+*/
+template <typename Engine>
+void pollFootprint(Engine& session)
+{
+	if (session.footprintEvery && ++session.sinceFootprint == session.footprintEvery)
+	{
+		session.sinceFootprint = 0;
+		measureBook(session).print(std::cerr);
+	}
+}
+
+/*
+Called by stream mode when no request is waiting. Compacts the book if compaction is on, enough requests went by since the last
+look, and slack and block maps, which are what compaction shrinks, are at least 1 MB and more than half of the book.
+Slack that only shallow levels hold cannot shrink, so compactBook() then releases nothing and nothing is reported.
+*/
+template <typename Engine>
+void compactIfIdle(Engine& session)
+{
+	const std::uint64_t checkAfter = 1 << 14;
+	const std::size_t minWaste = std::size_t(1) << 20;
+	if (!session.compactIdle || session.sinceCompactCheck < checkAfter)
+		return;
+
+	session.sinceCompactCheck = 0;
+	BookFootprint footprint = measureBook(session);
+	std::size_t waste = footprint.slack() + footprint.indexBytes;
+	if (waste < minWaste || waste * 2 <= footprint.levelBytes + footprint.orderBytes + footprint.indexBytes)
+		return;
+
+	if (std::size_t released = compactBook(session))
+		std::cerr << "compacted the book, " << released / 1024.0 << " KB released\n";
+}
+
+/*
+Set by SIGUSR1, asks for the session statistics to be printed to stderr.
+*/
+volatile std::sig_atomic_t statsRequested = 0;
+
+void onStatsSignal(int)
+{
+	statsRequested = 1;
+}
+
+template <typename Engine>
+void pollStatsRequest(const Engine& session)
+{
+	if (statsRequested)
+	{
+		statsRequested = 0;
+		session.stats.print(std::cerr, session.traders);
+	}
 }
 
-bool sell(Request& rq, std::map<int, std::queue<Request> >& Buy)
+/*
+Puts rq at the back of its price level. An iceberg shows at most its display quantity, the rest is hidden.
+*/
+template <typename Engine>
+void rest(Engine& session, typename Engine::Order& rq)
 {
-	if (Buy.empty() || Buy.rbegin()->first < rq.price)
+	if (rq.display > 0 && rq.quantity > rq.display)
+	{
+		rq.hidden = rq.quantity - rq.display;
+		rq.quantity = rq.display;
+	}
+	session.book.add(rq);
+}
+
+/*
+Matches rq against the opposite side of the book and rests the remainder, if any.
+The trades of the execution are appended to trades.
+*/
+template <typename Engine>
+void matchOrRest(Engine& session, typename Engine::Order& rq, std::vector<typename Engine::Trade>& trades)
+{
+	bool matched;
+	if (rq.side == 'B')
+		matched = buy(rq, session.book, trades, session.stp);
+	else
+		matched = sell(rq, session.book, trades, session.stp);
+
+	if (!matched)
+		rest(session, rq);
+
+	session.stats.record(rq, trades);
+	session.stats.recordDepth(session.book.depth('B'), session.book.depth('S'));
+	++session.sinceCompactCheck;
+	pollStatsRequest(session);
+	pollFootprint(session);
+}
+
+/*
+Turns request into order, interning its trader, and matches it, or in an auction session only rests it.
+The trades of the execution are appended to trades and order is left as matchOrRest() leaves it.
+Returns false, doing nothing, if the book cannot hold the request's price.
+*/
+template <typename Engine>
+bool submit(Engine& session, const Request& request, typename Engine::Order& order,
+	std::vector<typename Engine::Trade>& trades)
+{
+	if (!Engine::Book::accepts(request.price))
 		return false;
 
-	std::map<std::pair<std::string, int>, int> bought; // <trader, price> -> quantity
-	std::map<int, int> sold; // price -> quantity
+	order.trader = session.traders.intern(request.id);
+	order.seq = request.seq;
+	order.side = request.side;
+	order.quantity = request.quantity;
+	order.price = request.price;
+	order.display = request.display;
+	order.hidden = 0;
+
+	if (session.auction)
+	{
+		rest(session, order);
+		session.stats.recordDepth(session.book.depth('B'), session.book.depth('S'));
+		pollFootprint(session);
+	}
+	else
+		matchOrRest(session, order, trades);
+	return true;
+}
+
+/*
+Reports a request that was turned down: by submit() for its price unless why says otherwise.
+*/
+void reportRejected(const Request& rq, const char* why = "outside the book's price band")
+{
+	std::cerr << "skipping request " << why << ": " << rq.id << ' ' << rq.side << ' ' << rq.quantity << ' ' << rq.price
+		<< '\n';
+}
+
+/*
+Pins the calling engine thread to cpu if one was given and reports where it runs.
+*/
+void placeThread(const char* name, int cpu)
+{
+	if (cpu == -1)
+		return;
 
-	auto start = Buy.rbegin().base();
-	--start;
+	if (!pinCurrentThread(cpu))
+		std::cerr << name << ": cannot pin to cpu " << cpu << ": " << std::strerror(errno) << '\n';
+	std::cerr << name << ": " << describePlacement() << '\n';
+}
 
-	while (rq.quantity > 0 && !Buy.empty() && start->first >= rq.price)
+/*
+Auction uncross. Finds the price that executes the most quantity: for a price p, every bid at p or above can buy
+and every ask at p or below can sell, so the executable volume is min(cumulative bids from the top down to p,
+cumulative asks from the bottom up to p). Ties go to the price leaving the smaller imbalance, then to the lower price.
+Hidden iceberg quantity takes part. The orders are then filled at that single price, best price first and FIFO
+inside a level, and the trades are
+appended to trades aggregated per trader and side. Self-trade prevention does not apply to the auction.
+Returns the clearing price, or -1 if the book does not cross.
+*/
+template <typename Engine>
+int uncross(Engine& session, std::vector<typename Engine::Trade>& trades)
+{
+	using Id = typename Engine::Id;
+	using Level = typename Engine::Level;
+	auto& book = session.book;
+	if (book.empty('B') || book.empty('S') || book.bestPrice('B') < book.bestPrice('S'))
+		return -1;
+
+	// quantity per level, asks ascending and bids descending, only over the crossing range
+	int low = book.bestPrice('S'), high = book.bestPrice('B');
+	std::vector<std::pair<int, long long> > asks, bids;
+	auto levelTotal = [](const Level& level) {
+		long long total = 0;
+		for (const auto& order : level)
+			total += order.quantity + order.hidden;
+		return total;
+	};
+	book.forEach('S', [&](int price, const Level& level) {
+		if (price > high)
+			return false;
+		asks.push_back({ price, levelTotal(level) });
+		return true;
+	});
+	book.forEach('B', [&](int price, const Level& level) {
+		if (price < low)
+			return false;
+		bids.push_back({ price, levelTotal(level) });
+		return true;
+	});
+
+	// candidate prices are the level prices; sweep them ascending with supply growing and demand shrinking
+	std::vector<int> prices;
+	for (const auto& level : asks)
+		prices.push_back(level.first);
+	for (const auto& level : bids)
+		prices.push_back(level.first);
+	std::sort(prices.begin(), prices.end());
+	prices.erase(std::unique(prices.begin(), prices.end()), prices.end());
+
+	long long demand = 0, supply = 0;
+	for (const auto& level : bids)
+		demand += level.second;
+
+	std::size_t nextAsk = 0;
+	auto nextBid = bids.rbegin(); // lowest bid first
+	int best = -1;
+	long long bestVolume = 0, bestImbalance = 0;
+	for (int price : prices)
 	{
-		auto& Queue = start->second;
-		while (!Queue.empty() && rq.quantity > 0)
+		while (nextAsk < asks.size() && asks[nextAsk].first <= price)
+			supply += asks[nextAsk++].second;
+		while (nextBid != bids.rend() && nextBid->first < price)
+			demand -= (nextBid++)->second;
+
+		long long volume = std::min(demand, supply);
+		long long imbalance = demand > supply ? demand - supply : supply - demand;
+		if (volume > bestVolume || (volume == bestVolume && volume > 0 && imbalance < bestImbalance))
 		{
-			int dec = std::min(rq.quantity, Queue.front().quantity);
-			rq.quantity -= dec;
-			Queue.front().quantity -= dec;
+			best = price;
+			bestVolume = volume;
+			bestImbalance = imbalance;
+		}
+	}
 
-			bought[{Queue.front().id, Queue.front().price}] += dec;
-			sold[Queue.front().price] += dec;
+	if (best == -1)
+		return -1;
 
-			if (Queue.front().quantity == 0)
-				Queue.pop();
+	// fill both sides for bestVolume at the clearing price
+	std::map<Id, long long> filled[2]; // trader -> quantity, buys and sells
+	for (int side = 0; side < 2; ++side)
+	{
+		char name = side == 0 ? 'B' : 'S';
+		long long left = bestVolume;
+		while (left > 0)
+		{
+			Level& queue = book.best(name);
+			while (!queue.empty() && left > 0)
+			{
+				Id trader = queue.front().trader;
+				int dec = takeFront(queue, static_cast<int>(std::min<long long>(left, INT_MAX)), UINT64_MAX);
+				left -= dec;
+				filled[side][trader] += dec;
+			}
+			if (queue.empty())
+				book.popBest(name);
 		}
+	}
 
-		if (Queue.empty())
-			Buy.erase(start--);
+	for (int side = 0; side < 2; ++side)
+		for (const auto& cur : filled[side])
+			trades.push_back({ cur.first, side == 0 ? '+' : '-', static_cast<int>(cur.second), best });
+
+	session.stats.recordUncross(trades);
+	return best;
+}
+
+/*
+Prints the resting book as a ladder, asks from the highest price down, then bids from the best price down.
+*/
+template <typename Engine>
+void dumpBook(const Engine& session, std::ostream& output)
+{
+	using Level = typename Engine::Level;
+	auto printLevel = [&](char side, int price, const Level& level) {
+		output << side << ' ' << price << ':';
+		for (const auto& order : level)
+		{
+			output << ' ' << session.traders.name(order.trader) << ' ' << order.quantity;
+			if (order.hidden)
+				output << " (" << order.hidden << " hidden)";
+		}
+		output << '\n';
+	};
+
+	std::vector<std::pair<int, const Level*> > asks;
+	session.book.forEach('S', [&](int price, const Level& level) {
+		asks.push_back({ price, &level });
+		return true;
+	});
+
+	output << "book:\n";
+	for (auto it = asks.rbegin(); it != asks.rend(); ++it)
+		printLevel('S', it->first, *it->second);
+	session.book.forEach('B', [&](int price, const Level& level) {
+		printLevel('B', price, level);
+		return true;
+	});
+}
+
+/*
+Gateway thread body: parses requests from input and pushes them into the ingress queue.
+*/
+void runGateway(std::istream& input, IngressQueue<Request>& ingress, std::atomic<int>& liveGateways, int cpu)
+{
+	placeThread("parse thread", cpu);
+
+	std::string line;
+	Request rq;
+	while (std::getline(input, line))
+	{
+		if (parseRequest(line.data(), line.data() + line.size(), rq))
+			ingress.push(rq);
+		else if (line.find_first_not_of(" \t\r") != std::string::npos)
+			std::cerr << "skipping malformed request: " << line << '\n';
 	}
 
-	std::set<std::string> aggressorExe;
+	liveGateways.fetch_sub(1, std::memory_order_release);
+}
 
-	for (const auto& cur : bought)
+/*
+Gateway mode: serves clients on address and sends every trade back to the connection its trader last sent a request on.
+*/
+template <typename Engine>
+int runGatewayMode(Engine& session, const std::string& address)
+{
+	using Trade = typename Engine::Trade;
+	OrderGateway gateway(address);
+	if (!gateway.ok())
 	{
-		std::string trade = cur.first.first + "+"; // trader+
-		trade += std::to_string(cur.second) + "@" + std::to_string(cur.first.second); // count@price
-		aggressorExe.insert(trade);
+		std::cerr << "cannot listen on " << address << ": " << std::strerror(errno) << '\n';
+		return 1;
 	}
 
-	for (const auto& cur : sold)
+	PerTrader<typename Engine::Id, int> owner(-1); // trader -> connection, -1 once the connection is gone
+
+	Request rq;
+	typename Engine::Order order;
+	std::vector<Trade> trades;
+	std::map<int, std::vector<Trade> > routed; // connection -> its trades of one execution
+	std::string text;
+
+	auto onLine = [&](int conn, const char* line, std::size_t length) {
+		if (!parseRequest(line, line + length, rq))
+		{
+			gateway.send(conn, "error: expected <Trader> <Side> <Quantity> <Price>\n");
+			return;
+		}
+
+		rq.seq = session.seq++;
+		owner[session.traders.intern(rq.id)] = conn;
+
+		trades.clear();
+		if (!submit(session, rq, order, trades))
+		{
+			gateway.send(conn, "error: price outside the book's band\n");
+			return;
+		}
+
+		routed.clear();
+		for (const Trade& trade : trades)
+			if (owner[trade.trader] != -1)
+				routed[owner[trade.trader]].push_back(trade);
+
+		for (auto& cur : routed)
+		{
+			text.clear();
+			session.reporter.execution(session.traders, cur.second, text);
+			gateway.send(cur.first, text);
+		}
+	};
+
+	auto onClose = [&](int conn) {
+		owner.forEach([conn](const typename Engine::Id&, int& cur) {
+			if (cur == conn)
+				cur = -1;
+		});
+	};
+
+	gateway.run(onLine, onClose);
+	return 0;
+}
+
+/*
+Records of the shared memory transport. Each client process creates its own trade ring and stamps its requests
+with its pid; a request with side 'Q' says the client is done. A trade record holds one trade in the text format,
+last marks the end of the client's part of an execution line; an empty trade with last set tells the client that
+the engine is done with it.
+*/
+struct WireRequest
+{
+	char trader[16];
+	std::int32_t client; // pid of the sender, whose trades go to its ring /<name>.trades.<client>
+	char side;
+	std::int32_t quantity;
+	std::int32_t price;
+	std::int32_t display;
+};
+
+struct WireTrade
+{
+	char text[40];
+	char last;
+};
+
+std::string shmTradeRing(const std::string& name, std::int32_t client)
+{
+	return "/" + name + ".trades." + std::to_string(client);
+}
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+void onStopSignal(int)
+{
+	stopRequested = 1;
+}
+
+/*
+Shared memory mode: consumes requests from the ring /<name>.requests, fed by any number of client processes, and
+sends every trade to the ring of the client its trader last sent a request from, as the gateway mode does with
+connections. The rings carry trades as text records, whatever the session's reporter.
+Clients come and go; only SIGINT or SIGTERM ends the session. A client that died is dropped, with its trades, once
+its ring is full.
+*/
+template <typename Engine>
+int runShmMode(Engine& session, const std::string& name, bool useFutex, std::uint64_t capacity)
+{
+	using Trade = typename Engine::Trade;
+	ShmRing<WireRequest>* requests = ShmRing<WireRequest>::create("/" + name + ".requests", capacity);
+	if (!requests)
 	{
-		std::string trade = rq.id + "-"; // trader-
-		trade += std::to_string(cur.second) + "@" + std::to_string(cur.first); // count@price
-		aggressorExe.insert(trade);
+		std::cerr << "cannot create shared memory ring for " << name << ": " << std::strerror(errno) << '\n';
+		return 1;
 	}
 
-	if (!aggressorExe.empty())
-		printSet(aggressorExe);
+	struct sigaction sa{};
+	sa.sa_handler = onStopSignal;
+	sigaction(SIGINT, &sa, nullptr);
+	sigaction(SIGTERM, &sa, nullptr);
 
-	return rq.quantity == 0;
+	std::map<std::int32_t, ShmRing<WireTrade>*> clients; // pid -> its trade ring
+	PerTrader<typename Engine::Id, std::int32_t> owner(0); // trader -> client pid, 0 once the client is gone
+
+	// maps the ring of client on its first request
+	auto connect = [&](std::int32_t client) {
+		if (clients.count(client))
+			return true;
+		ShmRing<WireTrade>* ring = ShmRing<WireTrade>::open(shmTradeRing(name, client));
+		if (!ring)
+			return false;
+		clients[client] = ring;
+		return true;
+	};
+
+	// drops client; the ring of a dead one is unlinked, a live one does that itself
+	auto forget = [&](std::int32_t client) {
+		auto it = clients.find(client);
+		if (!it->second->creator_alive())
+			shm_unlink(shmTradeRing(name, client).c_str());
+		delete it->second;
+		clients.erase(it);
+		owner.forEach([client](const typename Engine::Id&, std::int32_t& cur) {
+			if (cur == client)
+				cur = 0;
+		});
+	};
+
+	// pushes out to client, forgetting the client if it died with its ring full
+	auto send = [&](std::int32_t client, const WireTrade& out) {
+		ShmRing<WireTrade>* ring = clients[client];
+		if (ring->push(out, [ring]() { return ring->creator_alive(); }))
+			return true;
+		std::cerr << "shm client " << client << " is gone, dropping its trades\n";
+		forget(client);
+		return false;
+	};
+
+	WireRequest wire;
+	WireTrade out, done{};
+	done.last = 1;
+	Request rq;
+	typename Engine::Order order;
+	std::vector<Trade> trades;
+	std::map<std::int32_t, std::vector<Trade> > routed; // client -> its trades of one execution
+	std::string text;
+
+	while (requests->pop(wire, useFutex, stopRequested))
+	{
+		if (!connect(wire.client))
+		{
+			std::cerr << "no trade ring for shm client " << wire.client << ", skipping its request\n";
+			continue;
+		}
+		if (wire.side == 'Q')
+		{
+			if (send(wire.client, done))
+				forget(wire.client);
+			continue;
+		}
+
+		rq.id.assign(wire.trader, strnlen(wire.trader, sizeof(wire.trader)));
+		rq.side = wire.side;
+		rq.quantity = wire.quantity;
+		rq.price = wire.price;
+		rq.display = wire.display;
+		if (!validRequest(rq))
+		{
+			// records come from other processes and get the checks parseRequest does on text
+			reportRejected(rq, "with invalid fields");
+			continue;
+		}
+		rq.seq = session.seq++;
+		owner[session.traders.intern(rq.id)] = wire.client;
+
+		trades.clear();
+		if (!submit(session, rq, order, trades))
+			reportRejected(rq);
+
+		routed.clear();
+		for (const Trade& trade : trades)
+			if (owner[trade.trader] != 0)
+				routed[owner[trade.trader]].push_back(trade);
+
+		for (auto& cur : routed)
+		{
+			sortTrades(cur.second, session.traders);
+			for (std::size_t i = 0; i < cur.second.size(); ++i)
+			{
+				text.clear();
+				appendTrade(text, cur.second[i], session.traders);
+				std::memset(out.text, 0, sizeof(out.text));
+				text.copy(out.text, sizeof(out.text) - 1);
+				out.last = i + 1 == cur.second.size();
+				if (!send(cur.first, out))
+					break;
+			}
+		}
+	}
+
+	// the session is over for the clients still there
+	while (!clients.empty())
+	{
+		std::int32_t client = clients.begin()->first;
+		if (send(client, done))
+			forget(client);
+	}
+
+	delete requests;
+	return 0;
+}
+
+/*
+Client side of the shared memory mode: sends the requests of stdin to the engine serving name and prints the
+trades it sends back for the traders this client sent requests for. Any number of clients can run at once.
+At the end of input the client tells the engine it is done and prints the trades still on their way. Gives up if
+the engine goes away.
+*/
+int runShmClient(const std::string& name)
+{
+	ShmRing<WireRequest>* requests = ShmRing<WireRequest>::open("/" + name + ".requests");
+	if (!requests)
+	{
+		std::cerr << "no engine is serving " << name << '\n';
+		return 1;
+	}
+
+	std::int32_t self = static_cast<std::int32_t>(getpid());
+	ShmRing<WireTrade>* output = ShmRing<WireTrade>::create(shmTradeRing(name, self), requests->capacity());
+	if (!output)
+	{
+		std::cerr << "cannot create shared memory ring for " << name << ": " << std::strerror(errno) << '\n';
+		delete requests;
+		return 1;
+	}
+
+	// shared, since the sender outlives this function if the engine leaves first
+	std::shared_ptr<std::atomic<bool> > inputDone = std::make_shared<std::atomic<bool> >(false);
+	std::thread sender([requests, self, inputDone]() {
+		auto engineAlive = [requests]() { return requests->creator_alive(); };
+		std::string line;
+		Request rq;
+		WireRequest wire;
+		while (std::getline(std::cin, line))
+		{
+			if (!parseRequest(line.data(), line.data() + line.size(), rq) || rq.id.size() >= sizeof(wire.trader))
+			{
+				std::cerr << "skipping malformed request: " << line << '\n';
+				continue;
+			}
+
+			std::memset(&wire, 0, sizeof(wire));
+			rq.id.copy(wire.trader, sizeof(wire.trader) - 1);
+			wire.client = self;
+			wire.side = rq.side;
+			wire.quantity = rq.quantity;
+			wire.price = rq.price;
+			wire.display = rq.display;
+			if (!requests->push(wire, engineAlive))
+				return;
+		}
+
+		*inputDone = true;
+		std::memset(&wire, 0, sizeof(wire));
+		wire.client = self;
+		wire.side = 'Q';
+		requests->push(wire, engineAlive);
+	});
+
+	// stop flag of the wait for trades: the engine died; the syscall is only made on every 1024th check
+	struct EngineGone
+	{
+		ShmRing<WireRequest>* mRing;
+		mutable unsigned mChecks;
+
+		explicit operator bool() const
+		{
+			return ++mChecks % 1024 == 0 && !mRing->creator_alive();
+		}
+	} engineGone{ requests, 0 };
+
+	WireTrade trade;
+	bool ended = false;
+	while (output->pop(trade, true, engineGone))
+	{
+		if (!trade.text[0])
+		{
+			ended = true;
+			break;
+		}
+		std::cout << trade.text << ' ';
+		if (trade.last)
+			std::cout << '\n';
+	}
+	delete output;
+
+	if (!*inputDone)
+	{
+		// still reading stdin for an engine that is gone or done with us
+		sender.detach();
+		std::cerr << "the engine serving " << name << (ended ? " ended the session" : " is gone") << '\n';
+		return ended ? 0 : 1;
+	}
+
+	sender.join();
+	delete requests;
+	return 0;
+}
+
+/*
+Checks the whole book. Returns an empty string if it is consistent, otherwise a description of the problem.
+restingTotal receives the total quantity resting on each side.
+*/
+template <typename Engine>
+std::string checkBook(const Engine& session, long long restingTotal[2])
+{
+	using Level = typename Engine::Level;
+	const auto& book = session.book;
+	std::string error;
+	for (int side = 0; side < 2 && error.empty(); ++side)
+	{
+		char name = side == 0 ? 'B' : 'S';
+		const Level* best = book.empty(name) ? nullptr : book.find(name, book.bestPrice(name));
+		if (!book.empty(name) && (!best || best->empty()))
+			return "best level at " + std::to_string(book.bestPrice(name)) + " is empty";
+
+		restingTotal[side] = 0;
+		book.forEach(name, [&](int price, const Level& level) {
+			if (level.empty())
+				error = "empty level left at " + std::to_string(price);
+
+			std::uint64_t lastSeq = 0;
+			for (auto order = level.begin(); order != level.end() && error.empty(); ++order)
+			{
+				const std::string& trader = session.traders.name(order->trader);
+				if (order->price != price || order->side != name)
+					error = "order of " + trader + " rests at the wrong level " + std::to_string(price);
+				else if (order->quantity <= 0 || order->hidden < 0)
+					error = "order of " + trader + " rests with quantity " + std::to_string(order->quantity);
+				// icebergs replenished by the same aggressor share its stamp
+				else if (order != level.begin() && lastSeq > order->seq)
+					error = "FIFO broken at level " + std::to_string(price);
+				lastSeq = order->seq;
+				restingTotal[side] += order->quantity + order->hidden;
+			}
+			return error.empty();
+		});
+	}
+	return error;
+}
+
+/*
+Checks what one execution could have changed: the book is not crossed, the levels the aggressor traded at are
+either gone or still have a live order in front, and a resting remainder went to the back of its level.
+*/
+template <typename Engine>
+std::string checkExecution(const Engine& session, const typename Engine::Order& rq,
+	const std::vector<typename Engine::Trade>& trades)
+{
+	const auto& book = session.book;
+	if (!book.empty('B') && !book.empty('S') && book.bestPrice('B') >= book.bestPrice('S'))
+		return "crossed book: bid " + std::to_string(book.bestPrice('B')) + " >= ask " + std::to_string(book.bestPrice('S'));
+
+	char own = rq.side, opposite = rq.side == 'B' ? 'S' : 'B';
+	for (const auto& trade : trades)
+	{
+		const typename Engine::Level* level = book.find(opposite, trade.price);
+		if (level && (level->empty() || level->front().quantity <= 0))
+			return "exhausted level left at " + std::to_string(trade.price);
+	}
+
+	if (rq.quantity > 0)
+	{
+		const typename Engine::Level* level = book.find(own, rq.price);
+		if (!level || level->empty() || level->back().seq != rq.seq || level->back().quantity != rq.quantity)
+			return "remainder did not rest at the back of " + std::to_string(rq.price);
+
+		if (level->size() > 1 && std::prev(level->end(), 2)->seq >= rq.seq)
+			return "FIFO broken at level " + std::to_string(rq.price);
+	}
+	return "";
+}
+
+/*
+Checks the trades of one execution: both sides balance, every aggressor trade respects its limit price.
+*/
+template <typename Order, typename Trade>
+std::string checkTrades(const Order& rq, const std::vector<Trade>& trades, long long& traded)
+{
+	char aggressorSign = rq.side == 'B' ? '+' : '-';
+	long long aggressorQty = 0, restingQty = 0;
+	for (const Trade& trade : trades)
+	{
+		if (trade.quantity <= 0)
+			return "trade with quantity " + std::to_string(trade.quantity);
+		if (trade.trader == rq.trader && trade.sign == aggressorSign)
+		{
+			aggressorQty += trade.quantity;
+			if (rq.side == 'B' ? trade.price > rq.price : trade.price < rq.price)
+				return "aggressor traded through its limit at " + std::to_string(trade.price);
+		}
+		else
+			restingQty += trade.quantity;
+	}
+
+	// a self trade under StpPolicy::None shows up as two trades of the aggressor, with both signs
+	if (aggressorQty != restingQty)
+		return "unbalanced execution: " + std::to_string(aggressorQty) + " vs " + std::to_string(restingQty);
+
+	traded += aggressorQty;
+	return "";
+}
+
+/*
+Deep book sweep benchmark: rests ordersPerLevel orders on each of levels ask levels, inserted in a shuffled order so
+that neighbouring levels and orders do not sit next to each other in memory, then times one buy sweeping all of them.
+Runs without and with the match loop prefetches and prints the time per level and per order of each.
+*/
+int runSweepBench(int levels, int ordersPerLevel, int rounds)
+{
+	std::mt19937_64 rng(1);
+	std::vector<int> slots;
+	for (int level = 0; level < levels; ++level)
+		for (int i = 0; i < ordersPerLevel; ++i)
+			slots.push_back(level);
+	std::shuffle(slots.begin(), slots.end(), rng);
+
+	for (bool prefetch : { false, true })
+	{
+		prefetchBook = prefetch;
+		double total = 0;
+		for (int round = 0; round < rounds; ++round)
+		{
+			MapEngine session;
+			std::vector<MapEngine::Trade> trades;
+			MapEngine::Order rq;
+			for (std::size_t i = 0; i < slots.size(); ++i)
+			{
+				rq = { session.traders.intern("T" + std::to_string(i % 16)), session.seq++, 'S', 1, 1000 + slots[i], 0, 0 };
+				rest(session, rq);
+			}
+
+			rq = { session.traders.intern("A"), session.seq++, 'B', static_cast<int>(slots.size()), 1000 + levels, 0, 0 };
+			auto start = std::chrono::steady_clock::now();
+			buy(rq, session.book, trades);
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+			total += elapsed.count();
+		}
+
+		std::cerr << "sweep " << (prefetch ? "with" : "without") << " prefetch: " << total / rounds * 1e9 / levels << " ns/level, "
+			<< total / rounds * 1e9 / slots.size() << " ns/order\n";
+	}
+	return 0;
 }
 
-int main()
+/*
+Property based stress harness. Generates count random requests from seed, first replays them without checks to
+measure throughput, then once more verifying every execution (balanced trades, limit prices respected, book not
+crossed, FIFO kept at the touched levels). One request in eight is an iceberg. Every checkEvery requests, and at the end, the whole book is scanned
+for FIFO order and empty levels, and quantity conservation is checked. Nothing is ever cancelled, so the book only
+grows and a full scan per request would make the run quadratic; --check-every=1 still does exactly that.
+For sanitizer runs build with -O1 -g -fsanitize=address,undefined.
+*/
+template <typename Engine>
+int runStress(StpPolicy stp, std::uint64_t count, std::uint64_t seed, std::uint64_t checkEvery)
 {
-	std::map<int, std::queue<Request> > Sell, Buy;
+	const int traderCount = 64, minPrice = 90, maxPrice = 110, maxQuantity = 50;
+
+	std::vector<Request> requests(count);
+	std::mt19937_64 rng(seed);
+	for (std::uint64_t i = 0; i < count; ++i)
+	{
+		Request& rq = requests[i];
+		rq.id = "T" + std::to_string(rng() % traderCount + 1);
+		rq.side = rng() % 2 ? 'B' : 'S';
+		rq.quantity = static_cast<int>(rng() % maxQuantity) + 1;
+		rq.price = minPrice + static_cast<int>(rng() % (maxPrice - minPrice + 1));
+		rq.display = rng() % 8 == 0 ? rq.quantity / 5 + 1 : 0;
+		rq.seq = i;
+	}
+
+	typename Engine::Order order;
+	std::vector<typename Engine::Trade> trades;
+
+	{
+		Engine session;
+		session.stp = stp;
+		auto start = std::chrono::steady_clock::now();
+		for (const Request& rq : requests)
+		{
+			trades.clear();
+			submit(session, rq, order, trades);
+		}
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+		std::cerr << "stress: " << count << " requests in " << elapsed.count() << " s, "
+			<< (elapsed.count() > 0 ? count / elapsed.count() : 0.0) << " requests/s\n";
+	}
+
+	Engine session;
+	session.stp = stp;
+	long long submitted[2] = { 0, 0 }, traded = 0, resting[2] = { 0, 0 };
+
+	for (std::uint64_t i = 0; i < count; ++i)
+	{
+		const Request& rq = requests[i];
+		submitted[rq.side == 'B' ? 0 : 1] += rq.quantity;
+
+		trades.clear();
+		std::string error;
+		if (!submit(session, rq, order, trades))
+			error = "price rejected by the book";
+		if (error.empty())
+			error = checkTrades(order, trades, traded);
+		if (error.empty())
+			error = checkExecution(session, order, trades);
+
+		if (error.empty() && ((i + 1) % checkEvery == 0 || i + 1 == count))
+		{
+			error = checkBook(session, resting);
+
+			// self-trade prevention cancels quantity, with it the book can only be checked for created quantity
+			for (int side = 0; side < 2 && error.empty(); ++side)
+			{
+				long long accounted = resting[side] + traded;
+				if (stp == StpPolicy::None ? accounted != submitted[side] : accounted > submitted[side])
+					error = std::string(side == 0 ? "buy" : "sell") + " quantity not conserved: submitted " + std::to_string(submitted[side])
+						+ ", resting " + std::to_string(resting[side]) + ", traded " + std::to_string(traded);
+			}
+		}
+
+		if (!error.empty())
+		{
+			std::cerr << "stress: request " << i << " (" << rq.id << ' ' << rq.side << ' ' << rq.quantity
+				<< ' ' << rq.price << "), seed " << seed << ": " << error << '\n';
+			return 1;
+		}
+	}
+
+	std::cerr << "stress: all invariants held, " << traded << " traded, " << resting[0] << " bid / " << resting[1] << " ask resting\n";
+	return 0;
+}
+
+#ifdef ENGINE_HAS_COROUTINES
+/*
+Async mode: the matching coroutine reads its input in chunks with the next read already in flight while it matches
+the current one, and hands output to a background write once a buffer fills, so neither side waits for the other.
+*/
+template <typename Engine>
+AsyncIo::Task matchAsync(AsyncIo& io, Engine& session, int in, int out)
+{
+	const std::size_t chunkSize = 1 << 20;
+	std::vector<char> chunks[2] = { std::vector<char>(chunkSize), std::vector<char>(chunkSize) };
+	std::string pendingOut[2]; // the one being written and the one being filled
+	int filling = 0;
+	std::string carry; // a line split between two chunks
+	AsyncIo::Pending reading = io.read(in, chunks[0].data(), chunkSize), writing;
 
 	Request rq;
+	typename Engine::Order order;
+	std::vector<typename Engine::Trade> trades;
+
+	auto process = [&](const char* begin, const char* end) {
+		if (!parseRequest(begin, end, rq))
+		{
+			if (std::string(begin, end).find_first_not_of(" \t\r") != std::string::npos)
+				std::cerr << "skipping malformed request: " << std::string(begin, end) << '\n';
+			return;
+		}
+
+		rq.seq = session.seq++;
+		trades.clear();
+		if (!submit(session, rq, order, trades))
+			reportRejected(rq);
+		if (!trades.empty())
+			session.reporter.execution(session.traders, trades, pendingOut[filling]);
+	};
+
+	auto flush = [&]() -> AsyncIo::Pending {
+		std::string& full = pendingOut[filling];
+		filling ^= 1;
+		pendingOut[filling].clear();
+		return io.write(out, full.data(), full.size());
+	};
+
+	int status = 0;
+	auto failed = [&status](const char* what) {
+		std::cerr << what << ": " << std::strerror(errno) << '\n';
+		status = 1;
+	};
 
-	while (std::cin >> rq)
+	for (int current = 0;; current ^= 1)
 	{
-		bool matched;
-		if (rq.side == 'B')
-			matched = buy(rq, Sell);
+		long n = co_await reading;
+		if (n < 0)
+		{
+			failed("read");
+			break;
+		}
+		if (n == 0)
+			break;
+		reading = io.read(in, chunks[current ^ 1].data(), chunkSize);
+
+		const char* begin = chunks[current].data();
+		const char* end = begin + n;
+		for (const char* newline; (newline = static_cast<const char*>(std::memchr(begin, '\n', end - begin))); begin = newline + 1)
+		{
+			if (carry.empty())
+				process(begin, newline);
+			else
+			{
+				carry.append(begin, newline);
+				process(carry.data(), carry.data() + carry.size());
+				carry.clear();
+			}
+		}
+		carry.append(begin, end);
+
+		if (pendingOut[filling].size() >= chunkSize)
+		{
+			// the other buffer is about to be refilled, its write must be done
+			if (writing.active() && co_await writing < 0)
+			{
+				failed("write");
+				break;
+			}
+			writing = flush();
+		}
+	}
+
+	if (status == 0)
+	{
+		if (!carry.empty())
+			process(carry.data(), carry.data() + carry.size());
+
+		if (session.auction)
+		{
+			trades.clear();
+			uncross(session, trades);
+			if (!trades.empty())
+				session.reporter.execution(session.traders, trades, pendingOut[filling]);
+		}
+
+		if (writing.active() && co_await writing < 0)
+			failed("write");
 		else
-			matched = sell(rq, Buy);
+		{
+			writing = flush();
+			if (co_await writing < 0)
+				failed("write");
+		}
+	}
 
-		if (!matched)
-			(rq.side == 'B' ? Buy : Sell)[rq.price].push(rq);
+	// an operation still in flight after an error uses the buffers, which go away with the frame
+	if (reading.active())
+		co_await reading;
+	if (writing.active())
+		co_await writing;
+	co_return status;
+}
+#endif
+
+/*
+Stream mode: one gateway thread per input ("-" is stdin, at most once) feeds the matching thread through the ingress
+queue, trades are printed to stdout. With an output cpu the printing moves to its own thread pinned there.
+Requests from one input are matched in their order there; across inputs the order is the one in which the gateways
+won their queue tickets, so it changes from run to run, as do the trades when inputs touch the same book.
+*/
+template <typename Engine>
+int runStreams(Engine& session, const std::vector<const char*>& inputs, std::size_t queueCapacity, bool ingressStats,
+	const PlacementOptions& placement)
+{
+	std::vector<std::ifstream> files;
+	files.reserve(inputs.size());
+	for (const char* path : inputs)
+	{
+		if (std::strcmp(path, "-") == 0)
+			continue;
+
+		files.emplace_back(path);
+		if (!files.back())
+		{
+			std::cerr << "cannot open " << path << '\n';
+			return 1;
+		}
+	}
+
+	IngressQueue<Request> ingress(queueCapacity);
+	std::atomic<int> liveGateways(static_cast<int>(inputs.size()));
+	std::vector<std::thread> gateways;
+
+	for (std::size_t i = 0, f = 0; i < inputs.size(); ++i)
+	{
+		std::istream& input = std::strcmp(inputs[i], "-") == 0 ? std::cin : files[f++];
+		int cpu = placement.parseCpus.empty() ? -1 : placement.parseCpus[i % placement.parseCpus.size()];
+		gateways.emplace_back(runGateway, std::ref(input), std::ref(ingress), std::ref(liveGateways), cpu);
+	}
+
+	IngressQueue<std::string> output(queueCapacity);
+	std::atomic<bool> matchingDone(false);
+	std::thread printer;
+
+	if (placement.outputCpu != -1)
+	{
+		printer = std::thread([&output, &matchingDone, &placement]() {
+			placeThread("output thread", placement.outputCpu);
+
+			std::string text;
+			std::uint64_t seq;
+			for (;;)
+			{
+				if (output.try_pop(text, seq))
+					std::cout.write(text.data(), static_cast<std::streamsize>(text.size()));
+				else if (matchingDone.load(std::memory_order_acquire))
+				{
+					// the matching thread is done pushing, drain what is left
+					while (output.try_pop(text, seq))
+						std::cout.write(text.data(), static_cast<std::streamsize>(text.size()));
+					return;
+				}
+				else
+					std::this_thread::yield();
+			}
+		});
+	}
+
+	Request rq;
+	typename Engine::Order order;
+	std::vector<typename Engine::Trade> trades;
+	std::string line;
+
+	auto emit = [&]() {
+		if (trades.empty())
+			return;
+
+		line.clear();
+		session.reporter.execution(session.traders, trades, line);
+		if (printer.joinable())
+			output.push(std::move(line));
+		else
+			std::cout.write(line.data(), static_cast<std::streamsize>(line.size()));
+	};
+
+	for (;;)
+	{
+		if (!ingress.try_pop(rq, rq.seq))
+		{
+			if (liveGateways.load(std::memory_order_acquire) != 0)
+			{
+				pollStatsRequest(session);
+				compactIfIdle(session);
+				std::this_thread::yield();
+				continue;
+			}
+
+			// every gateway has finished, so all of their pushes are visible now
+			if (!ingress.try_pop(rq, rq.seq))
+				break;
+		}
+
+		trades.clear();
+		if (!submit(session, rq, order, trades))
+			reportRejected(rq);
+		emit();
+	}
+
+	// the uncross is the one execution of an auction session
+	if (session.auction)
+	{
+		trades.clear();
+		uncross(session, trades);
+		emit();
 	}
 
-}
\ No newline at end of file
+	for (auto& gateway : gateways)
+		gateway.join();
+
+	if (printer.joinable())
+	{
+		matchingDone.store(true, std::memory_order_release);
+		printer.join();
+	}
+
+	if (ingressStats)
+	{
+		IngressQueue<Request>::Stats st = ingress.stats();
+		std::cerr << "ingress: " << st.enqueued << " requests, " << st.producerStalls << " producer stalls (queue full), "
+			<< st.consumerStalls << " consumer stalls (queue empty)\n";
+	}
+	return 0;
+}
+
+/*
+Stands for an engine type, to pick the instantiation main() runs.
+*/
+template <typename Engine>
+struct EngineTag
+{
+	using type = Engine;
+};
+
+int main(int argc, char* argv[])
+{
+	SessionOptions options;
+	bool printStats = false;
+	std::size_t queueCapacity = 1 << 16;
+	bool ingressStats = false;
+	std::string listenAddress;
+	std::string shmName, shmClient;
+	bool shmFutex = true;
+	std::uint64_t stressCount = 0, stressSeed = 1, stressCheckEvery = 1024;
+	PlacementOptions placement;
+	std::vector<int> cpus;
+	std::size_t arenaBytes = std::size_t(1) << 30;
+	Arena::Pages arenaPages = Arena::Pages::Transparent;
+	bool dumpAtEnd = false;
+	std::string variant = "map"; // which engine instantiation runs, see MapEngine
+	bool asyncIo = false;
+	int sweepLevels = 0;
+	std::vector<const char*> inputs; // one gateway thread per input, "-" is stdin
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strncmp(argv[i], "--stp=", 6) == 0 && parseStpPolicy(argv[i] + 6, options.stp))
+			continue;
+
+		if (std::strncmp(argv[i], "--queue=", 8) == 0)
+		{
+			queueCapacity = std::strtoull(argv[i] + 8, nullptr, 10);
+			if (queueCapacity >= 2 && (queueCapacity & (queueCapacity - 1)) == 0)
+				continue;
+		}
+		else if (std::strcmp(argv[i], "--stats") == 0)
+		{
+			printStats = true;
+			continue;
+		}
+		else if (std::strcmp(argv[i], "--auction") == 0)
+		{
+			options.auction = true;
+			continue;
+		}
+		else if (std::strcmp(argv[i], "--dump-book") == 0)
+		{
+			dumpAtEnd = true;
+			continue;
+		}
+		else if (std::strcmp(argv[i], "--ingress-stats") == 0)
+		{
+			ingressStats = true;
+			continue;
+		}
+		else if (std::strncmp(argv[i], "--listen=", 9) == 0)
+		{
+			listenAddress = argv[i] + 9;
+			continue;
+		}
+		else if (std::strncmp(argv[i], "--shm=", 6) == 0)
+		{
+			shmName = argv[i] + 6;
+			continue;
+		}
+		else if (std::strncmp(argv[i], "--shm-client=", 13) == 0)
+		{
+			shmClient = argv[i] + 13;
+			continue;
+		}
+		else if (std::strcmp(argv[i], "--shm-wait=spin") == 0 || std::strcmp(argv[i], "--shm-wait=futex") == 0)
+		{
+			shmFutex = std::strcmp(argv[i] + 11, "futex") == 0;
+			continue;
+		}
+		else if (std::strncmp(argv[i], "--stress=", 9) == 0)
+		{
+			stressCount = std::strtoull(argv[i] + 9, nullptr, 10);
+			if (stressCount > 0)
+				continue;
+		}
+		else if (std::strncmp(argv[i], "--check-every=", 14) == 0)
+		{
+			stressCheckEvery = std::strtoull(argv[i] + 14, nullptr, 10);
+			if (stressCheckEvery > 0)
+				continue;
+		}
+		else if (std::strncmp(argv[i], "--pin-match=", 12) == 0 && parseCpuList(argv[i] + 12, cpus) && cpus.size() == 1)
+		{
+			placement.matchCpu = cpus[0];
+			continue;
+		}
+		else if (std::strncmp(argv[i], "--pin-parse=", 12) == 0 && parseCpuList(argv[i] + 12, cpus))
+		{
+			placement.parseCpus = cpus;
+			continue;
+		}
+		else if (std::strncmp(argv[i], "--pin-output=", 13) == 0 && parseCpuList(argv[i] + 13, cpus) && cpus.size() == 1)
+		{
+			placement.outputCpu = cpus[0];
+			continue;
+		}
+		else if (std::strncmp(argv[i], "--arena-mb=", 11) == 0)
+		{
+			arenaBytes = std::strtoull(argv[i] + 11, nullptr, 10) << 20;
+			continue;
+		}
+		else if (std::strncmp(argv[i], "--huge-pages=", 13) == 0)
+		{
+			const char* kind = argv[i] + 13;
+			arenaPages = std::strcmp(kind, "explicit") == 0 ? Arena::Pages::Explicit
+				: std::strcmp(kind, "transparent") == 0 ? Arena::Pages::Transparent : Arena::Pages::Normal;
+			if (arenaPages != Arena::Pages::Normal || std::strcmp(kind, "off") == 0)
+				continue;
+		}
+		else if (std::strcmp(argv[i], "--engine=map") == 0 || std::strcmp(argv[i], "--engine=array") == 0
+			|| std::strcmp(argv[i], "--engine=string-ids") == 0 || std::strcmp(argv[i], "--engine=binary") == 0)
+		{
+			variant = argv[i] + 9;
+			continue;
+		}
+		else if (std::strncmp(argv[i], "--footprint-every=", 18) == 0)
+		{
+			options.footprintEvery = std::strtoull(argv[i] + 18, nullptr, 10);
+			if (options.footprintEvery > 0)
+				continue;
+		}
+		else if (std::strcmp(argv[i], "--compact-idle") == 0)
+		{
+			options.compactIdle = true;
+			continue;
+		}
+		else if (std::strcmp(argv[i], "--no-prefetch") == 0)
+		{
+			prefetchBook = false;
+			continue;
+		}
+		else if (std::strncmp(argv[i], "--sweep-bench=", 14) == 0)
+		{
+			sweepLevels = std::atoi(argv[i] + 14);
+			if (sweepLevels > 0)
+				continue;
+		}
+		else if (std::strcmp(argv[i], "--async-io") == 0)
+		{
+			asyncIo = true;
+			continue;
+		}
+		else if (std::strncmp(argv[i], "--seed=", 7) == 0)
+		{
+			stressSeed = std::strtoull(argv[i] + 7, nullptr, 10);
+			continue;
+		}
+		else if (argv[i][0] != '-' || std::strcmp(argv[i], "-") == 0)
+		{
+			// two gateway threads reading std::cin would race on it
+			if (std::strcmp(argv[i], "-") == 0 && std::find_if(inputs.begin(), inputs.end(),
+				[](const char* input) { return std::strcmp(input, "-") == 0; }) != inputs.end())
+			{
+				std::cerr << "stdin (-) can only be given once\n";
+				return 1;
+			}
+			inputs.push_back(argv[i]);
+			continue;
+		}
+
+		std::cerr << "usage: " << argv[0] << " [--stp=none|cancel-resting|cancel-aggressor|decrement-both]"
+			" [--queue=<power of two>] [--stats] [--ingress-stats] [--auction] [--dump-book]"
+			" [--pin-match=<cpu>] [--pin-parse=<cpu,...>] [--pin-output=<cpu>] [--arena-mb=<n>] [--huge-pages=off|transparent|explicit]"
+			" [--footprint-every=<n>] [--compact-idle] [--no-prefetch] [--engine=map|array|string-ids|binary]"
+			" [--listen=unix:<path>|tcp:<port> | --shm=<name> [--shm-wait=spin|futex] | --shm-client=<name> | --stress=<count> [--seed=<n>] [--check-every=<n>] | --sweep-bench=<levels> | [--async-io] input files, - for stdin...]\n";
+		return 1;
+	}
+
+	struct sigaction sa{};
+	sa.sa_handler = onStatsSignal;
+	sa.sa_flags = SA_RESTART;
+	sigaction(SIGUSR1, &sa, nullptr);
+
+	// the matching thread is this one; pin it before the book allocates anything, so that with
+	// the preferred memory policy every book page is first touched, and placed, on its node
+	if (placement.matchCpu != -1)
+	{
+		placeThread("matching thread", placement.matchCpu);
+
+		int cpu, node;
+		currentPlacement(cpu, node);
+		if (preferNode(node))
+			std::cerr << "matching thread: book memory preferred on node " << node << '\n';
+		else
+			std::cerr << "matching thread: cannot set memory policy: " << std::strerror(errno) << '\n';
+	}
+
+	// a zero size keeps the book on the general heap
+	if (arenaBytes && !bookArena().reserve(arenaBytes, arenaPages))
+		std::cerr << "cannot map the book arena, using the heap: " << std::strerror(errno) << '\n';
+	else if (arenaBytes && bookArena().stats().pages != arenaPages)
+		bookArena().print(std::cerr << "huge pages not available, ");
+
+	if (options.auction && (!listenAddress.empty() || !shmName.empty() || !shmClient.empty() || stressCount))
+	{
+		std::cerr << "--auction only works on input streams\n";
+		return 1;
+	}
+	if (!listenAddress.empty() && !inputs.empty())
+	{
+		std::cerr << "--listen does not take input files\n";
+		return 1;
+	}
+#ifdef ENGINE_HAS_COROUTINES
+	if (asyncIo && inputs.size() > 1)
+	{
+		std::cerr << "--async-io takes one input\n";
+		return 1;
+	}
+#else
+	if (asyncIo)
+	{
+		std::cerr << "--async-io needs a build with C++20 coroutines\n";
+		return 1;
+	}
+#endif
+
+	if (!shmClient.empty())
+		return runShmClient(shmClient);
+	if (sweepLevels)
+		return runSweepBench(sweepLevels, 8, 5);
+	if (inputs.empty())
+		inputs.push_back("-");
+
+	// runs the selected mode on a session of the engine type tag stands for
+	auto serve = [&](auto tag) -> int {
+		using Engine = typename decltype(tag)::type;
+		if (stressCount)
+			return runStress<Engine>(options.stp, stressCount, stressSeed, stressCheckEvery);
+
+		Engine session;
+		static_cast<SessionOptions&>(session) = options;
+
+		int status = 0;
+		if (!listenAddress.empty())
+			status = runGatewayMode(session, listenAddress);
+		else if (!shmName.empty())
+			status = runShmMode(session, shmName, shmFutex, queueCapacity);
+#ifdef ENGINE_HAS_COROUTINES
+		else if (asyncIo)
+		{
+			int in = std::strcmp(inputs[0], "-") == 0 ? STDIN_FILENO : open(inputs[0], O_RDONLY);
+			if (in == -1)
+			{
+				std::cerr << "cannot open " << inputs[0] << '\n';
+				return 1;
+			}
+
+			AsyncIo io;
+			AsyncIo::Task task = matchAsync(io, session, in, STDOUT_FILENO);
+			status = io.run(task);
+			if (in != STDIN_FILENO)
+				close(in);
+		}
+#endif
+		else
+			status = runStreams(session, inputs, queueCapacity, ingressStats, placement);
+
+		if (dumpAtEnd)
+			dumpBook(session, std::cerr);
+
+		if (printStats)
+		{
+			session.stats.print(std::cerr, session.traders);
+			measureBook(session).print(std::cerr);
+			bookArena().print(std::cerr);
+		}
+		return status;
+	};
+
+	if (variant == "array")
+		return serve(EngineTag<ArrayEngine>());
+	if (variant == "string-ids")
+		return serve(EngineTag<StringIdEngine>());
+	if (variant == "binary")
+		return serve(EngineTag<BinaryEngine>());
+	return serve(EngineTag<MapEngine>());
+}